@@ -1,21 +1,380 @@
 ﻿#include <vector>
 #include <algorithm>
+#include <array>
 #include <functional> 
 #include <memory>
 #include <cstdlib>
+#include <cstdint>
 #include <cmath>
 #include <ctime>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <utility>
+#include <new>
+#include <string>
+
+// Resident set sizes for the benchmark and file mapping for world snapshots. windows.h is
+// trimmed so it does not clash with raylib names.
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#define NOUSER
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+#endif
 
 #include <raylib.h>
 #include <raymath.h>
+#include <rlgl.h>
+
+#if !defined(NO_SIMD)
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE 1
+#endif
+#endif
+
+// --- MEMORY STATS ---
+// Global operator new/delete replacements that count heap allocations, so hot
+// paths can be checked for zero steady-state allocations.
+namespace MemoryStats {
+#if defined(__linux__)
+    // A "VmRSS:"-style line of /proc/self/status, in KiB; 0 if missing
+    inline uint64_t ProcStatusKb(const char* key) {
+        FILE* f = fopen("/proc/self/status", "r");
+        if (!f) return 0;
+        char line[128];
+        uint64_t kb = 0;
+        const size_t keyLen = strlen(key);
+        while (fgets(line, sizeof(line), f)) {
+            if (strncmp(line, key, keyLen) == 0) {
+                kb = strtoull(line + keyLen, nullptr, 10);
+                break;
+            }
+        }
+        fclose(f);
+        return kb;
+    }
+#endif
+
+    inline std::atomic<uint64_t> allocations{ 0 };
+    inline std::atomic<uint64_t> bytesAllocated{ 0 };
+
+    inline uint64_t Allocations() {
+        return allocations.load(std::memory_order_relaxed);
+    }
+
+    inline uint64_t BytesAllocated() {
+        return bytesAllocated.load(std::memory_order_relaxed);
+    }
+
+    // Resident set now, in KiB; 0 where it cannot be read
+    inline uint64_t CurrentRssKb() {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+            return pmc.WorkingSetSize / 1024;
+        }
+        return 0;
+#elif defined(__APPLE__)
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+            return 0;
+        }
+        return static_cast<uint64_t>(info.resident_size) / 1024;
+#elif defined(__linux__)
+        return ProcStatusKb("VmRSS:");
+#else
+        return 0;
+#endif
+    }
+
+    // High-water resident set in KiB, since process start or the last
+    // successful ResetPeakRss()
+    inline uint64_t PeakRssKb() {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS pmc;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+            return pmc.PeakWorkingSetSize / 1024;
+        }
+        return 0;
+#elif defined(__linux__)
+        // VmHWM, unlike ru_maxrss, drops all the way on a reset
+        if (uint64_t kb = ProcStatusKb("VmHWM:")) return kb;
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss) / 1024; // bytes on macOS
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#endif
+#endif
+    }
+
+    // Lowers the high-water mark to the current resident set. Only Linux
+    // offers this (/proc/self/clear_refs); false elsewhere.
+    inline bool ResetPeakRss() {
+#if defined(__linux__)
+        FILE* f = fopen("/proc/self/clear_refs", "w");
+        if (!f) return false;
+        const bool ok = fputs("5", f) >= 0;
+        return fclose(f) == 0 && ok;
+#else
+        return false;
+#endif
+    }
+}
+
+// The whole new/delete family is replaced so every allocation form is counted
+// and freed by its matching call. They stay out of line: once GCC inlines
+// malloc into one side and free into the other it can no longer pair them and
+// warns with -Wmismatched-new-delete.
+#if defined(_MSC_VER)
+#define MEMORY_STATS_NOINLINE __declspec(noinline)
+#else
+#define MEMORY_STATS_NOINLINE __attribute__((noinline))
+#endif
+
+namespace MemoryStats {
+    inline void Count(size_t n) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytesAllocated.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    inline void* Allocate(size_t n) noexcept {
+        Count(n);
+        return malloc(n ? n : 1);
+    }
+
+    inline void* AllocateAligned(size_t n, std::align_val_t al) noexcept {
+        Count(n);
+        const size_t align = static_cast<size_t>(al);
+#if defined(_WIN32)
+        return _aligned_malloc(n ? n : 1, align);
+#else
+        void* p = nullptr;
+        return posix_memalign(&p, align < sizeof(void*) ? sizeof(void*) : align, n ? n : 1) == 0 ? p : nullptr;
+#endif
+    }
+
+    inline void FreeAligned(void* p) noexcept {
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+}
 
-// --- UTILS ---
-namespace Utils {
-    inline static float RandomFloat(float min, float max) {
-        return min + static_cast<float>(rand()) / RAND_MAX * (max - min);
+MEMORY_STATS_NOINLINE void* operator new(size_t n) {
+    if (void* p = MemoryStats::Allocate(n)) {
+        return p;
     }
+    throw std::bad_alloc();
+}
+
+MEMORY_STATS_NOINLINE void* operator new[](size_t n) {
+    if (void* p = MemoryStats::Allocate(n)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+MEMORY_STATS_NOINLINE void* operator new(size_t n, const std::nothrow_t&) noexcept {
+    return MemoryStats::Allocate(n);
+}
+
+MEMORY_STATS_NOINLINE void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+    return MemoryStats::Allocate(n);
+}
+
+MEMORY_STATS_NOINLINE void* operator new(size_t n, std::align_val_t al) {
+    if (void* p = MemoryStats::AllocateAligned(n, al)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+MEMORY_STATS_NOINLINE void* operator new[](size_t n, std::align_val_t al) {
+    if (void* p = MemoryStats::AllocateAligned(n, al)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+MEMORY_STATS_NOINLINE void* operator new(size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return MemoryStats::AllocateAligned(n, al);
+}
+
+MEMORY_STATS_NOINLINE void* operator new[](size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return MemoryStats::AllocateAligned(n, al);
+}
+
+MEMORY_STATS_NOINLINE void operator delete(void* p) noexcept {
+    free(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete(void* p, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    free(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete(void* p, std::align_val_t) noexcept {
+    MemoryStats::FreeAligned(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete[](void* p, std::align_val_t) noexcept {
+    MemoryStats::FreeAligned(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    MemoryStats::FreeAligned(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+    MemoryStats::FreeAligned(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    MemoryStats::FreeAligned(p);
+}
+
+MEMORY_STATS_NOINLINE void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    MemoryStats::FreeAligned(p);
 }
 
+// --- RANDOM ---
+// xoshiro128** generator. Each instance is an independent stream, seeded from
+// (seed, stream) through splitmix64, so subsystems and threads can own their
+// own generator and a run is reproducible from the seed alone.
+class Rng {
+public:
+    Rng() : Rng(0, 0) {}
+
+    Rng(uint64_t seed, uint64_t stream) {
+        Seed(seed, stream);
+    }
+
+    void Seed(uint64_t seed, uint64_t stream) {
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ull);
+        for (int i = 0; i < 4; i += 2) {
+            uint64_t z = SplitMix64(x);
+            s[i] = static_cast<uint32_t>(z);
+            s[i + 1] = static_cast<uint32_t>(z >> 32);
+        }
+        if ((s[0] | s[1] | s[2] | s[3]) == 0) s[0] = 1; // all-zero state is a fixed point
+    }
+
+    uint32_t NextU32() {
+        const uint32_t result = Rotl(s[1] * 5, 7) * 9;
+        const uint32_t t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 11);
+        return result;
+    }
+
+    // [0, 1) with the full 24-bit float mantissa
+    float Unit() {
+        return static_cast<float>(NextU32() >> 8) * (1.f / 16777216.f);
+    }
+
+    float Float(float min, float max) {
+        return min + Unit() * (max - min);
+    }
+
+    // Inclusive range, multiply-shift reduction
+    int Int(int min, int max) {
+        uint64_t span = static_cast<uint64_t>(static_cast<int64_t>(max) - min + 1);
+        return min + static_cast<int>((static_cast<uint64_t>(NextU32()) * span) >> 32);
+    }
+
+    struct State {
+        uint32_t s[4];
+    };
+
+    State GetState() const {
+        return { { s[0], s[1], s[2], s[3] } };
+    }
+
+    void SetState(const State& st) {
+        memcpy(s, st.s, sizeof(s));
+    }
+
+    // Batch form for spawn bursts: n uniform floats in [min, max)
+    void FillFloats(float* out, size_t n, float min, float max) {
+        const float scale = (max - min) * (1.f / 16777216.f);
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = min + static_cast<float>(NextU32() >> 8) * scale;
+        }
+    }
+
+private:
+    static uint32_t Rotl(uint32_t x, int k) {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    static uint64_t SplitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint32_t s[4];
+};
+
+// Stream ids, one generator per consumer so adding draws to one system does
+// not shift the sequence seen by another
+enum RngStream : uint64_t {
+    RNG_STREAM_SPAWN = 1,
+    RNG_STREAM_SPAWN_TIMER = 2,
+    RNG_STREAM_FRAGMENTS = 3,
+    RNG_STREAM_PARTICLES = 4, // render side only, never part of the simulation state
+};
+
 // --- TRANSFORM, PHYSICS, LIFETIME, RENDERABLE ---
 struct TransformA {
     Vector2 position{};
@@ -39,9 +398,10 @@ public:
         return inst;
     }
 
-    void Init(int w, int h, const char* title) {
+    // targetFps 0 leaves the frame rate uncapped
+    void Init(int w, int h, const char* title, int targetFps) {
         InitWindow(w, h, title);
-        SetTargetFPS(60);
+        SetTargetFPS(targetFps);
         screenW = w;
         screenH = h;
     }
@@ -55,396 +415,4715 @@ public:
         EndDrawing();
     }
 
-    void DrawPoly(const Vector2& pos, int sides, float radius, float rot) {
-        DrawPolyLines(pos, sides, radius, rot, WHITE);
-    }
+    // Batched submission: primitives are queued during the frame and Flush() sends
+    // them layer by layer, one rlgl vertex run per (primitive, colour) bucket, so a
+    // whole layer collapses into a handful of GPU draws instead of one per entity.
+    enum Layer : uint8_t { LAYER_PROJECTILES, LAYER_BAR_BACK, LAYER_BAR_FILL, LAYER_OUTLINES, LAYER_PARTICLES, LAYER_SHIPS, LAYER_COUNT };
 
-    int Width() const {
-        return screenW;
-    }
+    struct BatchStats {
+        int primitives = 0;
+        int vertexRuns = 0;
+    };
 
-    int Height() const {
-        return screenH;
+    void QueueTriangle(Vector2 a, Vector2 b, Vector2 c, Color color, Layer layer) {
+        auto& v = Bucket(layer, RL_TRIANGLES, color);
+        v.push_back(a);
+        v.push_back(b);
+        v.push_back(c);
     }
 
-private:
-    Renderer() = default;
-
-    int screenW{};
-    int screenH{};
-};
+    void QueueRect(const Rectangle& r, Color color, Layer layer) {
+        if (r.width <= 0.f || r.height <= 0.f) return;
+        // Counter-clockwise like DrawRectanglePro, backface culling is on
+        Vector2 tl = { r.x, r.y };
+        Vector2 bl = { r.x, r.y + r.height };
+        Vector2 br = { r.x + r.width, r.y + r.height };
+        Vector2 tr = { r.x + r.width, r.y };
+        auto& v = Bucket(layer, RL_TRIANGLES, color);
+        v.insert(v.end(), { tl, bl, br, tl, br, tr });
+    }
 
-// --- ASTEROID HIERARCHY ---
+    // LOD stand-in for something too small or numerous to outline: a 2px dash
+    void QueuePoint(Vector2 pos, Color color, Layer layer) {
+        auto& v = Bucket(layer, RL_LINES, color);
+        v.push_back({ pos.x - 1.f, pos.y });
+        v.push_back({ pos.x + 1.f, pos.y });
+    }
 
-class Asteroid {
-public:
-    Asteroid(int screenW, int screenH) {
-        init(screenW, screenH);
+    void QueueCircle(Vector2 center, float radius, Color color, Layer layer) {
+        auto& v = Bucket(layer, RL_TRIANGLES, color);
+        for (int s = 0; s < CIRCLE_SEGMENTS; ++s) {
+            const Vector2& d0 = UnitCircle()[s];
+            const Vector2& d1 = UnitCircle()[s + 1];
+            v.push_back(center);
+            v.push_back({ center.x + d1.x * radius, center.y + d1.y * radius });
+            v.push_back({ center.x + d0.x * radius, center.y + d0.y * radius });
+        }
     }
-    void SetupHP() {
-        hp = baseHP * static_cast<int>(render.size);
-        maxHP = hp;
+
+    // Same vertices as DrawPolyLines. The side count is fixed at compile time, so
+    // the unit polygon is computed once and each outline costs one sin/cos pair.
+    template <int Sides>
+    void QueuePolyLines(Vector2 center, float radius, float rotDeg, Color color, Layer layer) {
+        static const std::array<Vector2, Sides + 1> unit = [] {
+            std::array<Vector2, Sides + 1> u{};
+            for (int i = 0; i <= Sides; ++i) {
+                float a = 2.f * PI * i / Sides;
+                u[i] = { cosf(a), sinf(a) };
+            }
+            return u;
+        }();
+        auto& v = Bucket(layer, RL_LINES, color);
+        const float c = cosf(rotDeg * DEG2RAD) * radius;
+        const float s = sinf(rotDeg * DEG2RAD) * radius;
+        for (int i = 0; i < Sides; ++i) {
+            v.push_back({ center.x + unit[i].x * c - unit[i].y * s, center.y + unit[i].x * s + unit[i].y * c });
+            v.push_back({ center.x + unit[i + 1].x * c - unit[i + 1].y * s, center.y + unit[i + 1].x * s + unit[i + 1].y * c });
+        }
     }
-    virtual ~Asteroid() = default;
 
-    bool Update(float dt) {
-        transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
-        transform.rotation += physics.rotationSpeed * dt;
-        if (transform.position.x < -GetRadius() || transform.position.x > Renderer::Instance().Width() + GetRadius() ||
-            transform.position.y < -GetRadius() || transform.position.y > Renderer::Instance().Height() + GetRadius())
-            return false;
-        return true;
+    // Textured quad from the sprite atlas. Every sprite shares the one atlas
+    // texture, so a layer's sprites go out as a single textured run.
+    void SetSpriteTexture(const Texture2D& texture) {
+        spriteTexture = texture;
     }
-    virtual void Draw() const {
-        float barWidth = GetRadius() * 2;
-        float hpPercent = (float)hp / (float)maxHP;
-        Rectangle backBar = { transform.position.x - barWidth / 2, transform.position.y - GetRadius() - 10, barWidth, 5 };
-        Rectangle hpBar = { transform.position.x - barWidth / 2, transform.position.y - GetRadius() - 10, barWidth * hpPercent, 5 };
-        DrawRectangleRec(backBar, RED);
-        DrawRectangleRec(hpBar, BLUE);
+
+    void QueueSprite(const Rectangle& src, const Rectangle& dst, Color tint, Layer layer) {
+        if (dst.width <= 0.f || dst.height <= 0.f) return;
+        sprites[layer].push_back({ src, dst, tint });
     }
 
-    Vector2 GetPosition() const {
-        return transform.position;
+    // Submits everything queued since the last flush, geometry before sprites
+    // within a layer. Bucket storage is kept, so steady-state frames do not allocate.
+    void Flush() {
+        stats = {};
+        for (int layer = 0; layer < LAYER_COUNT; ++layer) {
+            for (auto& batch : batches) {
+                if (batch.layer != layer || batch.verts.empty()) continue;
+                Submit(batch);
+                batch.verts.clear();
+            }
+            SubmitSprites(sprites[layer]);
+            sprites[layer].clear();
+        }
     }
 
-    float constexpr GetRadius() const {
-        return 16.f * (float)render.size;
+    const BatchStats& Stats() const {
+        return stats;
     }
 
-    int GetDamage() const {
-        return baseDamage * static_cast<int>(render.size);
+    int Width() const {
+        return screenW;
     }
 
-    int GetSize() const {
-        return static_cast<int>(render.size);
+    int Height() const {
+        return screenH;
     }
 
-    void TakeDamage(int dmg) {
-        hp -= dmg;
+private:
+    Renderer() = default;
+
+    struct Batch {
+        Layer                layer;
+        int                  mode;
+        Color                color;
+        std::vector<Vector2> verts;
+    };
+
+    std::vector<Vector2>& Bucket(Layer layer, int mode, Color color) {
+        for (auto& batch : batches) {
+            if (batch.layer == layer && batch.mode == mode && batch.color.r == color.r &&
+                batch.color.g == color.g && batch.color.b == color.b && batch.color.a == color.a) {
+                return batch.verts;
+            }
+        }
+        batches.push_back({ layer, mode, color, {} });
+        return batches.back().verts;
     }
 
-    bool IsDestroyed() const {
-        return hp <= 0;
+    void Submit(const Batch& batch) {
+        const size_t perPrimitive = (batch.mode == RL_LINES) ? 2 : 3;
+        const size_t chunk = MAX_RUN_VERTICES - MAX_RUN_VERTICES % perPrimitive;
+        const size_t n = batch.verts.size();
+        for (size_t start = 0; start < n; start += chunk) {
+            const size_t count = std::min(chunk, n - start);
+            rlCheckRenderBatchLimit(static_cast<int>(count));
+            rlBegin(batch.mode);
+            rlColor4ub(batch.color.r, batch.color.g, batch.color.b, batch.color.a);
+            for (size_t i = start; i < start + count; ++i) {
+                rlVertex2f(batch.verts[i].x, batch.verts[i].y);
+            }
+            rlEnd();
+            stats.vertexRuns++;
+        }
+        stats.primitives += static_cast<int>(n / perPrimitive);
     }
 
-protected:
-    void init(int screenW, int screenH) {
-        render.size = static_cast<Renderable::Size>(1 << GetRandomValue(0, 2));
+    struct SpriteQuad {
+        Rectangle src;
+        Rectangle dst;
+        Color     tint;
+    };
 
-        switch (GetRandomValue(0, 3)) {
-        case 0:
-            transform.position = { Utils::RandomFloat(0, screenW), -GetRadius() };
-            break;
-        case 1:
-            transform.position = { screenW + GetRadius(), Utils::RandomFloat(0, screenH) };
-            break;
-        case 2:
-            transform.position = { Utils::RandomFloat(0, screenW), screenH + GetRadius() };
-            break;
-        default:
-            transform.position = { -GetRadius(), Utils::RandomFloat(0, screenH) };
-            break;
+    void SubmitSprites(const std::vector<SpriteQuad>& quads) {
+        if (quads.empty() || spriteTexture.id == 0) return;
+        const float invW = 1.f / spriteTexture.width;
+        const float invH = 1.f / spriteTexture.height;
+        const size_t chunk = MAX_RUN_VERTICES / 4;
+        rlSetTexture(spriteTexture.id);
+        for (size_t start = 0; start < quads.size(); start += chunk) {
+            const size_t end = std::min(quads.size(), start + chunk);
+            rlCheckRenderBatchLimit(static_cast<int>(4 * (end - start)));
+            rlBegin(RL_QUADS);
+            for (size_t i = start; i < end; ++i) {
+                const SpriteQuad& q = quads[i];
+                const float u0 = q.src.x * invW, u1 = (q.src.x + q.src.width) * invW;
+                const float v0 = q.src.y * invH, v1 = (q.src.y + q.src.height) * invH;
+                // Counter-clockwise like DrawTexturePro
+                rlColor4ub(q.tint.r, q.tint.g, q.tint.b, q.tint.a);
+                rlTexCoord2f(u0, v0); rlVertex2f(q.dst.x, q.dst.y);
+                rlTexCoord2f(u0, v1); rlVertex2f(q.dst.x, q.dst.y + q.dst.height);
+                rlTexCoord2f(u1, v1); rlVertex2f(q.dst.x + q.dst.width, q.dst.y + q.dst.height);
+                rlTexCoord2f(u1, v0); rlVertex2f(q.dst.x + q.dst.width, q.dst.y);
+            }
+            rlEnd();
+            stats.vertexRuns++;
         }
+        rlSetTexture(0);
+        stats.primitives += static_cast<int>(quads.size());
+    }
 
-        float maxOff = fminf(screenW, screenH) * 0.1f;
-        float ang = Utils::RandomFloat(0, 2 * PI);
-        float rad = Utils::RandomFloat(0, maxOff);
-        Vector2 center = {
-            screenW * 0.5f + cosf(ang) * rad,
-            screenH * 0.5f + sinf(ang) * rad
-        };
-
-        Vector2 dir = Vector2Normalize(Vector2Subtract(center, transform.position));
-        physics.velocity = Vector2Scale(dir, Utils::RandomFloat(SPEED_MIN, SPEED_MAX));
-        physics.rotationSpeed = Utils::RandomFloat(ROT_MIN, ROT_MAX);
-        transform.rotation = Utils::RandomFloat(0, 360);
+    static const Vector2* UnitCircle() {
+        static const auto table = [] {
+            std::array<Vector2, CIRCLE_SEGMENTS + 1> t{};
+            for (int s = 0; s <= CIRCLE_SEGMENTS; ++s) {
+                float a = 2.f * PI * s / CIRCLE_SEGMENTS;
+                t[s] = { cosf(a), sinf(a) };
+            }
+            return t;
+        }();
+        return table.data();
     }
 
-    TransformA transform;
-    Physics    physics;
-    Renderable render;
+    static constexpr int    CIRCLE_SEGMENTS = 16;
+    static constexpr size_t MAX_RUN_VERTICES = 6144; // well inside the default rlgl batch
 
-    int baseDamage = 0;
-    int baseHP = 10;
-    int hp = 0;
-    int maxHP = 0;
+    int screenW{};
+    int screenH{};
 
-    static constexpr float SPEED_MIN = 20.f;
-    static constexpr float SPEED_MAX = 120.f;
-    static constexpr float ROT_MIN = 40.f;
-    static constexpr float ROT_MAX = 150.f;
-};
+    std::vector<Batch> batches;
+    BatchStats         stats;
 
-class TriangleAsteroid : public Asteroid {
-public:
-    TriangleAsteroid(int w, int h) : Asteroid(w, h) {
-        baseDamage = 5;
-        baseHP = 30;
-    }
-    void Draw() const override {
-        Asteroid::Draw();
-        Renderer::Instance().DrawPoly(transform.position, 3, GetRadius(), transform.rotation);
-    }
+    Texture2D                                         spriteTexture{};
+    std::array<std::vector<SpriteQuad>, LAYER_COUNT> sprites;
 };
 
-class SquareAsteroid : public Asteroid {
-public:
-    SquareAsteroid(int w, int h) : Asteroid(w, h) {
-        baseDamage = 10;
-        baseHP = 60;
-    }
-    void Draw() const override {
-        Asteroid::Draw();
-        Renderer::Instance().DrawPoly(transform.position, 4, GetRadius(), transform.rotation);
+// --- ASSETS ---
+// Loads every image once and hands out index handles. Screen-sized images
+// (the background) stay standalone textures; sprites are packed into a single
+// atlas texture by BuildAtlas(), so they all draw with one texture binding.
+// Restarts and extra ships reuse the handles and never touch the disk.
+struct TextureHandle {
+    uint32_t index = INVALID;
+
+    bool IsNull() const {
+        return index == INVALID;
     }
+
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
 };
 
-class PentagonAsteroid : public Asteroid {
-public:
-    PentagonAsteroid(int w, int h) : Asteroid(w, h) {
-        baseDamage = 15;
-        baseHP = 90;
-    }
-    void Draw() const override {
-        Asteroid::Draw();
-        Renderer::Instance().DrawPoly(transform.position, 5, GetRadius(), transform.rotation);
+struct SpriteHandle {
+    uint32_t index = INVALID;
+
+    bool IsNull() const {
+        return index == INVALID;
     }
+
+    static constexpr uint32_t INVALID = 0xFFFFFFFFu;
 };
 
-class RedHeavyAsteroid : public Asteroid {
+class AssetCache {
 public:
-    RedHeavyAsteroid(int w, int h) : Asteroid(w, h) {
-        baseDamage = 20;
-        baseHP = 150;
-        SetupHP();
-    }
-    void Draw() const override {
-        Asteroid::Draw();
-        Renderer::Instance().DrawPoly(transform.position, 6, GetRadius(), transform.rotation);
+    static AssetCache& Instance() {
+        static AssetCache inst;
+        return inst;
     }
-};
 
-// Shape selector
-enum class AsteroidShape { TRIANGLE = 3, SQUARE = 4, PENTAGON = 5, REDHEAVY = 6, RANDOM = 0 };
+    TextureHandle LoadTexture(const char* path) {
+        for (uint32_t i = 0; i < textures.size(); ++i) {
+            if (textures[i].path == path) return { i };
+        }
+        Texture2D texture = ::LoadTexture(path);
+        diskLoads++;
+        if (texture.id == 0) {
+            TraceLog(LOG_WARNING, "Failed to load %s", path);
+        }
+        textures.push_back({ path, texture });
+        return { static_cast<uint32_t>(textures.size() - 1) };
+    }
 
-// Factory
-static inline std::unique_ptr<Asteroid> MakeAsteroid(int w, int h, AsteroidShape shape) {
-    switch (shape) {
-    case AsteroidShape::TRIANGLE:
-        return std::make_unique<TriangleAsteroid>(w, h);
-    case AsteroidShape::SQUARE:
-        return std::make_unique<SquareAsteroid>(w, h);
-    case AsteroidShape::PENTAGON:
-        return std::make_unique<PentagonAsteroid>(w, h);
-    case AsteroidShape::REDHEAVY:
-        return std::make_unique<RedHeavyAsteroid>(w, h);
-    default: {
-        // Randomly select from available shapes 3,4,5,6
-        int shapeVal = 3 + GetRandomValue(0, 3); // 3..6
-        return MakeAsteroid(w, h, static_cast<AsteroidShape>(shapeVal));
+    // id 0 (draws nothing) for a null handle or a failed load
+    const Texture2D& Get(TextureHandle h) const {
+        static const Texture2D none{};
+        return h.IsNull() ? none : textures[h.index].texture;
     }
+
+    // Image file destined for the atlas, decoded once per path
+    SpriteHandle LoadSprite(const char* path) {
+        for (uint32_t i = 0; i < sprites.size(); ++i) {
+            if (sprites[i].name == path) return { i };
+        }
+        Image image = LoadImage(path);
+        diskLoads++;
+        if (image.data == nullptr) {
+            TraceLog(LOG_WARNING, "Failed to load %s", path);
+        }
+        return AddSprite(path, image);
     }
-}
 
-// --- PROJECTILE HIERARCHY ---
-enum class WeaponType { LASER, BULLET, SIDE_BLASTER, COUNT };
+    // Takes ownership of a generated image; it is released when the atlas is built
+    SpriteHandle AddSprite(const char* name, Image image) {
+        sprites.push_back({ name, image, {} });
+        return { static_cast<uint32_t>(sprites.size() - 1) };
+    }
 
+    // Shelf-packs every pending sprite into one texture. Call once, after all
+    // sprites are added and before drawing.
+    void BuildAtlas() {
+        std::vector<uint32_t> order(sprites.size());
+        for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return sprites[a].image.height > sprites[b].image.height;
+        });
 
-class Projectile {
-public:
-    Projectile(Vector2 pos, Vector2 vel, int dmg, WeaponType wt)
-    {
-        transform.position = pos;
-        physics.velocity = vel;
-        baseDamage = dmg;
-        type = wt;
-    }
-    bool Update(float dt) {
-        transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
-
-        if (transform.position.x < 0 ||
-            transform.position.x > Renderer::Instance().Width() ||
-            transform.position.y < 0 ||
-            transform.position.y > Renderer::Instance().Height())
-        {
-            return true;
-        }
-        return false;
-    }
-    void Draw() const {
-        if (type == WeaponType::BULLET) {
-            DrawCircleV(transform.position, 5.f, WHITE);
+        int width = ATLAS_MIN_WIDTH;
+        for (const Sprite& sp : sprites) {
+            while (width < sp.image.width + 2 * ATLAS_PADDING) width *= 2;
         }
-        else if (type == WeaponType::LASER) {
-            static constexpr float LASER_LENGTH = 30.f;
-            Rectangle lr = { transform.position.x - 2.f, transform.position.y - LASER_LENGTH, 4.f, LASER_LENGTH };
-            DrawRectangleRec(lr, BLUE);
+        int x = ATLAS_PADDING, y = ATLAS_PADDING, shelf = 0;
+        for (uint32_t i : order) {
+            Sprite& sp = sprites[i];
+            if (sp.image.data == nullptr) continue;
+            if (x + sp.image.width + ATLAS_PADDING > width) {
+                x = ATLAS_PADDING;
+                y += shelf + ATLAS_PADDING;
+                shelf = 0;
+            }
+            sp.rect = { static_cast<float>(x), static_cast<float>(y),
+                static_cast<float>(sp.image.width), static_cast<float>(sp.image.height) };
+            x += sp.image.width + ATLAS_PADDING;
+            shelf = std::max(shelf, sp.image.height);
         }
-        else if (type == WeaponType::SIDE_BLASTER) {
-            const float radius = 10.f;
-            Vector2 p1 = { transform.position.x, transform.position.y - radius };
-            Vector2 p2 = { transform.position.x - radius * 0.866f, transform.position.y + radius * 0.5f };
-            Vector2 p3 = { transform.position.x + radius * 0.866f, transform.position.y + radius * 0.5f };
-            DrawTriangle(p1, p2, p3, GREEN);
+        int height = ATLAS_MIN_WIDTH;
+        while (height < y + shelf + ATLAS_PADDING) height *= 2;
+
+        Image atlasImage = GenImageColor(width, height, BLANK);
+        for (Sprite& sp : sprites) {
+            if (sp.image.data == nullptr) continue;
+            Rectangle src = { 0.f, 0.f, sp.rect.width, sp.rect.height };
+            ImageDraw(&atlasImage, sp.image, src, sp.rect, WHITE);
+            UnloadImage(sp.image);
+            sp.image = {};
         }
+        atlas = LoadTextureFromImage(atlasImage);
+        UnloadImage(atlasImage);
+        // The ship is drawn scaled down; projectile sprites sample level 0
+        GenTextureMipmaps(&atlas);
+        SetTextureFilter(atlas, TEXTURE_FILTER_TRILINEAR);
     }
-    Vector2 GetPosition() const {
-        return transform.position;
+
+    const Texture2D& Atlas() const {
+        return atlas;
+    }
+
+    // Source rectangle in the atlas; zero-sized for a failed load
+    Rectangle SourceRect(SpriteHandle h) const {
+        return h.IsNull() ? Rectangle{} : sprites[h.index].rect;
     }
 
-    float GetRadius() const {
-        return (type == WeaponType::BULLET) ? 5.f : 2.f;
+    uint32_t DiskLoads() const {
+        return diskLoads;
     }
 
-    int GetDamage() const {
-        return baseDamage;
+    void Unload() {
+        for (Entry& e : textures) {
+            if (e.texture.id != 0) UnloadTexture(e.texture);
+        }
+        textures.clear();
+        for (Sprite& sp : sprites) {
+            if (sp.image.data != nullptr) UnloadImage(sp.image);
+        }
+        sprites.clear();
+        if (atlas.id != 0) UnloadTexture(atlas);
+        atlas = {};
     }
 
 private:
-    TransformA transform;
-    Physics    physics;
-    int        baseDamage;
-    WeaponType type;
-};
+    AssetCache() = default;
 
-inline static std::vector<Projectile> MakeProjectile(WeaponType wt, const Vector2 pos, float speed) {
-    std::vector<Projectile> result;
+    struct Entry {
+        std::string path;
+        Texture2D   texture;
+    };
 
-    if (wt == WeaponType::LASER) {
-        result.push_back(Projectile(pos, { 0, -speed }, 10, wt));
-    }
-    else if (wt == WeaponType::BULLET) {
-        result.push_back(Projectile(pos, { 0, -speed }, 3, wt));
-    }
-    else if (wt == WeaponType::SIDE_BLASTER) {
-        result.push_back(Projectile(pos, { -speed, 0 }, 5, wt));
-        result.push_back(Projectile(pos, { speed, 0 }, 5, wt));
-    }
+    struct Sprite {
+        std::string name;
+        Image       image;
+        Rectangle   rect;
+    };
 
-    return result;
-}
+    static constexpr int ATLAS_MIN_WIDTH = 256;
+    static constexpr int ATLAS_PADDING = 4; // keeps mip levels from bleeding across sprites
 
+    std::vector<Entry>  textures;
+    std::vector<Sprite> sprites;
+    Texture2D           atlas{};
+    uint32_t            diskLoads = 0;
+};
 
-// --- SHIP HIERARCHY ---
-class Ship {
-public:
-    Ship(int screenW, int screenH) {
-        transform.position = {
-            screenW * 0.5f,
-            screenH * 0.5f
-        };
-        hp = 100;
-        maxHP = 100;
-        speed = 500.f;
-        alive = true;
+// --- KINEMATICS ---
+// Batch integration over SoA arrays: pos += vel * dt for a whole array in one
+// pass, plus an out-of-bounds mask that feeds straight into the stores'
+// RemoveFlagged(). AVX and SSE paths handle 8/4 entities per step, the scalar
+// loop covers the tail (and everything when SIMD is unavailable or NO_SIMD is set).
+namespace Kinematics {
+    struct Bounds {
+        float minX, minY, maxX, maxY;
+    };
 
-        // per-weapon fire rate & spacing
-        fireRateLaser = 10.f; // shots/sec
-        fireRateBullet = 30.f;
-        spacingLaser = 40.f; // px between lasers
-        spacingBullet = 20.f;
+    // mask[i] = 1 when the new position lies outside bounds grown by margin[i]
+    // (margin may be null for zero margin), else 0.
+    inline void Integrate(float* x, float* y, const float* vx, const float* vy, const float* margin,
+        size_t n, float dt, Bounds b, uint8_t* mask) {
+        size_t i = 0;
+#if defined(SIMD_AVX)
+        const __m256 vdt = _mm256_set1_ps(dt);
+        const __m256 vminX = _mm256_set1_ps(b.minX), vmaxX = _mm256_set1_ps(b.maxX);
+        const __m256 vminY = _mm256_set1_ps(b.minY), vmaxY = _mm256_set1_ps(b.maxY);
+        for (; i + 8 <= n; i += 8) {
+            __m256 px = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(vx + i), vdt));
+            __m256 py = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), vdt));
+            _mm256_storeu_ps(x + i, px);
+            _mm256_storeu_ps(y + i, py);
+            __m256 m = margin ? _mm256_loadu_ps(margin + i) : _mm256_setzero_ps();
+            __m256 out = _mm256_or_ps(
+                _mm256_or_ps(_mm256_cmp_ps(px, _mm256_sub_ps(vminX, m), _CMP_LT_OQ),
+                    _mm256_cmp_ps(px, _mm256_add_ps(vmaxX, m), _CMP_GT_OQ)),
+                _mm256_or_ps(_mm256_cmp_ps(py, _mm256_sub_ps(vminY, m), _CMP_LT_OQ),
+                    _mm256_cmp_ps(py, _mm256_add_ps(vmaxY, m), _CMP_GT_OQ)));
+            int bits = _mm256_movemask_ps(out);
+            for (int k = 0; k < 8; ++k) {
+                mask[i + k] = static_cast<uint8_t>((bits >> k) & 1);
+            }
+        }
+#elif defined(SIMD_SSE)
+        const __m128 vdt = _mm_set1_ps(dt);
+        const __m128 vminX = _mm_set1_ps(b.minX), vmaxX = _mm_set1_ps(b.maxX);
+        const __m128 vminY = _mm_set1_ps(b.minY), vmaxY = _mm_set1_ps(b.maxY);
+        for (; i + 4 <= n; i += 4) {
+            __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(vx + i), vdt));
+            __m128 py = _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(_mm_loadu_ps(vy + i), vdt));
+            _mm_storeu_ps(x + i, px);
+            _mm_storeu_ps(y + i, py);
+            __m128 m = margin ? _mm_loadu_ps(margin + i) : _mm_setzero_ps();
+            __m128 out = _mm_or_ps(
+                _mm_or_ps(_mm_cmplt_ps(px, _mm_sub_ps(vminX, m)), _mm_cmpgt_ps(px, _mm_add_ps(vmaxX, m))),
+                _mm_or_ps(_mm_cmplt_ps(py, _mm_sub_ps(vminY, m)), _mm_cmpgt_ps(py, _mm_add_ps(vmaxY, m))));
+            int bits = _mm_movemask_ps(out);
+            for (int k = 0; k < 4; ++k) {
+                mask[i + k] = static_cast<uint8_t>((bits >> k) & 1);
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            x[i] += vx[i] * dt;
+            y[i] += vy[i] * dt;
+            float m = margin ? margin[i] : 0.f;
+            mask[i] = static_cast<uint8_t>(x[i] < b.minX - m || x[i] > b.maxX + m ||
+                y[i] < b.minY - m || y[i] > b.maxY + m);
+        }
     }
-    virtual ~Ship() = default;
-    virtual void Update(float dt) = 0;
-    virtual void Draw() const = 0;
 
-    void TakeDamage(int dmg) {
-        if (!alive) return;
-        hp -= dmg;
-        if (hp <= 0) alive = false;
+    // life -= dt; sets mask[i] once life has run out, leaves it alone otherwise,
+    // so it can follow Integrate() on the same mask
+    inline void Expire(float* life, size_t n, float dt, uint8_t* mask) {
+        size_t i = 0;
+#if defined(SIMD_AVX)
+        const __m256 vdt = _mm256_set1_ps(dt);
+        const __m256 zero = _mm256_setzero_ps();
+        for (; i + 8 <= n; i += 8) {
+            __m256 l = _mm256_sub_ps(_mm256_loadu_ps(life + i), vdt);
+            _mm256_storeu_ps(life + i, l);
+            int bits = _mm256_movemask_ps(_mm256_cmp_ps(l, zero, _CMP_LE_OQ));
+            for (int k = 0; k < 8; ++k) {
+                mask[i + k] |= static_cast<uint8_t>((bits >> k) & 1);
+            }
+        }
+#elif defined(SIMD_SSE)
+        const __m128 vdt = _mm_set1_ps(dt);
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            __m128 l = _mm_sub_ps(_mm_loadu_ps(life + i), vdt);
+            _mm_storeu_ps(life + i, l);
+            int bits = _mm_movemask_ps(_mm_cmple_ps(l, zero));
+            for (int k = 0; k < 4; ++k) {
+                mask[i + k] |= static_cast<uint8_t>((bits >> k) & 1);
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            life[i] -= dt;
+            mask[i] |= static_cast<uint8_t>(life[i] <= 0.f);
+        }
+    }
+
+    // angle += speed * dt
+    inline void Advance(float* angle, const float* speed, size_t n, float dt) {
+        size_t i = 0;
+#if defined(SIMD_AVX)
+        const __m256 vdt = _mm256_set1_ps(dt);
+        for (; i + 8 <= n; i += 8) {
+            _mm256_storeu_ps(angle + i,
+                _mm256_add_ps(_mm256_loadu_ps(angle + i), _mm256_mul_ps(_mm256_loadu_ps(speed + i), vdt)));
+        }
+#elif defined(SIMD_SSE)
+        const __m128 vdt = _mm_set1_ps(dt);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_ps(angle + i, _mm_add_ps(_mm_loadu_ps(angle + i), _mm_mul_ps(_mm_loadu_ps(speed + i), vdt)));
+        }
+#endif
+        for (; i < n; ++i) {
+            angle[i] += speed[i] * dt;
+        }
+    }
+}
+
+// --- ASTEROIDS ---
+
+// Asteroid kinds differ only in these constants. The kind id stored per
+// asteroid indexes ASTEROID_KINDS; a new kind is a new row (plus an enum name
+// if it should be selectable by key).
+struct AsteroidKindTraits {
+    uint8_t sides;
+    int     baseHP;     // scaled by size
+    int     baseDamage; // scaled by size
+    Color   color;
+};
+
+static constexpr AsteroidKindTraits ASTEROID_KINDS[] = {
+    /* TRIANGLE */ { 3,  30,  5, Color{ 255, 255, 255, 255 } },
+    /* SQUARE   */ { 4,  60, 10, Color{ 255, 255, 255, 255 } },
+    /* PENTAGON */ { 5,  90, 15, Color{ 255, 255, 255, 255 } },
+    /* REDHEAVY */ { 6, 150, 20, Color{ 255,  90,  90, 255 } },
+};
+static constexpr int ASTEROID_KIND_COUNT = static_cast<int>(sizeof(ASTEROID_KINDS) / sizeof(ASTEROID_KINDS[0]));
+
+// Shape selector; values are kind ids, RANDOM picks one per spawn
+enum class AsteroidShape : uint8_t { TRIANGLE, SQUARE, PENTAGON, REDHEAVY, RANDOM = 0xFF };
+static_assert(static_cast<int>(AsteroidShape::REDHEAVY) < ASTEROID_KIND_COUNT, "every named shape needs a kind row");
+
+// Queues outlines for the listed asteroids; those with radius <= pointRadius
+// become points. One pass per kind with the side count and colour as
+// compile-time constants, so each pass is a straight inlined loop.
+template <size_t... K>
+static inline void QueueAsteroidOutlines(Renderer& renderer, const float* x, const float* y, const float* r,
+    const float* rot, const uint8_t* kind, const uint32_t* rows, size_t n, float pointRadius, std::index_sequence<K...>) {
+    auto pass = [&](auto k) {
+        constexpr AsteroidKindTraits traits = ASTEROID_KINDS[decltype(k)::value];
+        for (size_t j = 0; j < n; ++j) {
+            const uint32_t i = rows[j];
+            if (kind[i] != decltype(k)::value) continue;
+            if (r[i] <= pointRadius) {
+                renderer.QueuePoint({ x[i], y[i] }, traits.color, Renderer::LAYER_OUTLINES);
+            }
+            else {
+                renderer.QueuePolyLines<traits.sides>({ x[i], y[i] }, r[i], rot[i], traits.color, Renderer::LAYER_OUTLINES);
+            }
+        }
+    };
+    (pass(std::integral_constant<size_t, K>{}), ...);
+}
+
+static inline void QueueAsteroidOutlines(Renderer& renderer, const float* x, const float* y, const float* r,
+    const float* rot, const uint8_t* kind, const uint32_t* rows, size_t n, float pointRadius) {
+    QueueAsteroidOutlines(renderer, x, y, r, rot, kind, rows, n, pointRadius, std::make_index_sequence<ASTEROID_KIND_COUNT>{});
+}
+
+// Stable reference to a pooled asteroid. Dense indices move on removal, the
+// handle does not; a handle whose asteroid was released fails the generation check.
+struct AsteroidHandle {
+    uint32_t slot = INVALID_SLOT;
+    uint32_t generation = 0;
+
+    bool IsNull() const {
+        return slot == INVALID_SLOT;
+    }
+
+    static constexpr uint32_t INVALID_SLOT = 0xFFFFFFFFu;
+};
+
+// One piece of a destroyed asteroid, waiting to become a row
+struct AsteroidFragment {
+    float   x;
+    float   y;
+    float   velX;
+    float   velY;
+    float   rotation;
+    float   rotationSpeed;
+    uint8_t size; // Renderable::Size
+    uint8_t kind;
+};
+
+// One array of a world snapshot as it sits in the file, for checking an image
+// before any of it is restored
+struct ColumnView {
+    const void* data;
+    size_t      count; // elements
+};
+
+// Structure-of-arrays asteroid storage. The old per-shape subclasses only differed
+// in side count and base HP/damage, so every asteroid is a row across these arrays
+// and the update, collision and draw passes walk them linearly. Removal is
+// swap-and-pop, so indices are not stable across a removal.
+//
+// The store is also a fixed-capacity pool: Init() sizes every array once, slots
+// come from a free list (O(1) acquire/release) and each slot carries a
+// generation that is bumped on release to catch stale handles.
+struct AsteroidStore {
+    std::vector<float>   posX;
+    std::vector<float>   posY;
+    std::vector<float>   velX;
+    std::vector<float>   velY;
+    std::vector<float>   rotation;
+    std::vector<float>   rotationSpeed;
+    std::vector<float>   radius;
+    std::vector<int>     hp;
+    std::vector<int>     maxHP;
+    std::vector<int>     damage;
+    std::vector<uint8_t> size;  // Renderable::Size
+    std::vector<uint8_t> kind;  // index into ASTEROID_KINDS
+    std::vector<uint32_t> slot; // pool slot owning each row
+
+    struct PoolStats {
+        uint64_t acquired = 0;
+        uint64_t released = 0;
+        uint64_t rejectedFull = 0;
+        uint64_t staleHandles = 0;
+        size_t   peak = 0;
+    };
+
+    void Init(size_t capacity) {
+        ForEachArray([capacity](auto& arr) {
+            arr.clear();
+            arr.reserve(capacity);
+        });
+        slotToIndex.assign(capacity, FREE_MARK);
+        slotGeneration.assign(capacity, 0);
+        freeSlots.resize(capacity);
+        for (size_t i = 0; i < capacity; ++i) {
+            freeSlots[i] = static_cast<uint32_t>(capacity - 1 - i); // pop hands out slot 0 first
+        }
+    }
+
+    size_t Size() const {
+        return posX.size();
+    }
+
+    size_t Capacity() const {
+        return slotToIndex.size();
+    }
+
+    bool IsFull() const {
+        return freeSlots.empty();
+    }
+
+    const PoolStats& Stats() const {
+        return stats;
+    }
+
+    // Positions in ForEachColumn order of the columns CheckImage looks into
+    enum Column : uint32_t {
+        COLUMN_SIZE = 10, COLUMN_KIND, COLUMN_SLOT, COLUMN_SLOT_TO_INDEX, COLUMN_SLOT_GENERATION, COLUMN_FREE_SLOTS,
+        COLUMN_COUNT
+    };
+
+    // Whether COLUMN_COUNT snapshot columns make a consistent pool of capacity
+    // slots: row arrays of one length within capacity, slot tables of exactly
+    // capacity, kinds and sizes in range, and every slot either owning the row
+    // that points back at it or marked free and on the free list once. A store
+    // restored from an image that passes never indexes out of bounds. seen is
+    // scratch.
+    static bool CheckImage(const ColumnView* columns, size_t capacity, std::vector<uint8_t>& seen) {
+        const size_t n = columns[0].count;
+        for (uint32_t c = 0; c < COLUMN_SLOT_TO_INDEX; ++c) {
+            if (columns[c].count != n) return false;
+        }
+        if (n > capacity || capacity >= FREE_MARK || columns[COLUMN_SLOT_TO_INDEX].count != capacity ||
+            columns[COLUMN_SLOT_GENERATION].count != capacity || columns[COLUMN_FREE_SLOTS].count != capacity - n) {
+            return false;
+        }
+        const auto* sizes = static_cast<const uint8_t*>(columns[COLUMN_SIZE].data);
+        const auto* kinds = static_cast<const uint8_t*>(columns[COLUMN_KIND].data);
+        const auto* slots = static_cast<const uint32_t*>(columns[COLUMN_SLOT].data);
+        const auto* indexOfSlot = static_cast<const uint32_t*>(columns[COLUMN_SLOT_TO_INDEX].data);
+        const auto* freeList = static_cast<const uint32_t*>(columns[COLUMN_FREE_SLOTS].data);
+        seen.assign(capacity, 0);
+        for (size_t i = 0; i < n; ++i) {
+            if (kinds[i] >= ASTEROID_KIND_COUNT) return false;
+            if (sizes[i] != Renderable::SMALL && sizes[i] != Renderable::MEDIUM && sizes[i] != Renderable::LARGE) return false;
+            if (slots[i] >= capacity || indexOfSlot[slots[i]] != i) return false;
+            seen[slots[i]] = 1;
+        }
+        for (size_t f = 0; f < capacity - n; ++f) {
+            const uint32_t s = freeList[f];
+            if (s >= capacity || seen[s] || indexOfSlot[s] != FREE_MARK) return false;
+            seen[s] = 1;
+        }
+        return true;
+    }
+
+    // Every array that makes up the store, rows then pool bookkeeping, for flat
+    // world snapshots. Restoring them resets the pool, so handles taken before a
+    // restore must not be used after it.
+    template <typename Fn>
+    void ForEachColumn(Fn&& fn) {
+        ForEachColumnOf(*this, fn);
+    }
+
+    template <typename Fn>
+    void ForEachColumn(Fn&& fn) const {
+        ForEachColumnOf(*this, fn);
+    }
+
+    // Releases every live asteroid; outstanding handles become stale
+    void Clear() {
+        while (Size() > 0) {
+            RemoveAt(Size() - 1);
+        }
+    }
+
+    AsteroidHandle HandleAt(size_t i) const {
+        return { slot[i], slotGeneration[slot[i]] };
+    }
+
+    bool IsValid(AsteroidHandle h) const {
+        return h.slot < Capacity() && slotGeneration[h.slot] == h.generation && !IsFreeSlot(h.slot);
+    }
+
+    // Dense index of a live handle, or -1 if it is stale
+    long long IndexOf(AsteroidHandle h) const {
+        return IsValid(h) ? static_cast<long long>(slotToIndex[h.slot]) : -1;
+    }
+
+    // Generation-checked release; a stale handle is counted and ignored
+    bool Release(AsteroidHandle h) {
+        long long idx = IndexOf(h);
+        if (idx < 0) {
+            stats.staleHandles++;
+            return false;
+        }
+        RemoveAt(static_cast<size_t>(idx));
+        return true;
+    }
+
+    Vector2 GetPosition(size_t i) const {
+        return { posX[i], posY[i] };
+    }
+
+    void TakeDamage(size_t i, int dmg) {
+        hp[i] -= dmg;
+    }
+
+    bool IsDestroyed(size_t i) const {
+        return hp[i] <= 0;
+    }
+
+    // Acquires a row for a new asteroid entering from a random edge, aimed near
+    // the centre. Returns a null handle when the pool is exhausted.
+    AsteroidHandle Spawn(int screenW, int screenH, AsteroidShape shape, Rng& rng) {
+        return SpawnBatch(1, screenW, screenH, shape, rng) ? HandleAt(Size() - 1) : AsteroidHandle{};
+    }
+
+    // Spawns up to count asteroids in one pass. Every column grows once inside
+    // the reserved capacity, then rows are filled in place, each with the same
+    // random draws as a single Spawn. Returns how many fit in the pool; the
+    // rest are counted as rejected.
+    size_t SpawnBatch(size_t count, int screenW, int screenH, AsteroidShape shape, Rng& rng) {
+        if (count > freeSlots.size()) {
+            stats.rejectedFull += count - freeSlots.size();
+            count = freeSlots.size();
+        }
+        if (count == 0) return 0;
+        const size_t base = Size();
+        ForEachArray([n = base + count](auto& arr) { arr.resize(n); });
+        for (size_t i = base; i < base + count; ++i) {
+            WriteSpawnRow(i, screenW, screenH, shape, rng);
+            AcquireRow(i);
+        }
+        stats.peak = std::max(stats.peak, Size());
+        return count;
+    }
+
+    // Inserts queued fragments the same way: one resize, then rows written in
+    // place. HP and damage follow the kind and the fragment's size. Returns how
+    // many fit in the pool.
+    size_t SpawnFragments(const AsteroidFragment* fragments, size_t count) {
+        if (count > freeSlots.size()) {
+            stats.rejectedFull += count - freeSlots.size();
+            count = freeSlots.size();
+        }
+        if (count == 0) return 0;
+        const size_t base = Size();
+        ForEachArray([n = base + count](auto& arr) { arr.resize(n); });
+        for (size_t k = 0; k < count; ++k) {
+            const AsteroidFragment& f = fragments[k];
+            const AsteroidKindTraits& traits = ASTEROID_KINDS[f.kind];
+            const size_t i = base + k;
+            posX[i] = f.x;
+            posY[i] = f.y;
+            velX[i] = f.velX;
+            velY[i] = f.velY;
+            rotation[i] = f.rotation;
+            rotationSpeed[i] = f.rotationSpeed;
+            radius[i] = RadiusOf(f.size);
+            hp[i] = traits.baseHP * f.size;
+            maxHP[i] = hp[i];
+            damage[i] = traits.baseDamage * f.size;
+            size[i] = f.size;
+            kind[i] = f.kind;
+            AcquireRow(i);
+        }
+        stats.peak = std::max(stats.peak, Size());
+        return count;
+    }
+
+    static float RadiusOf(int sz) {
+        return 16.f * static_cast<float>(sz);
+    }
+
+    // Swap-and-pop: the last asteroid takes row i, its slot is repointed and
+    // the removed slot goes back on the free list with a new generation
+    void RemoveAt(size_t i) {
+        const uint32_t freed = slot[i];
+        slotToIndex[slot.back()] = static_cast<uint32_t>(i);
+        ForEachArray([i](auto& arr) {
+            arr[i] = arr.back();
+            arr.pop_back();
+        });
+        slotGeneration[freed]++;
+        slotToIndex[freed] = FREE_MARK;
+        freeSlots.push_back(freed);
+        stats.released++;
+    }
+
+    // Removes every flagged asteroid. Walks backwards so the element swapped
+    // into a slot has already been visited.
+    void RemoveFlagged(const std::vector<uint8_t>& flags) {
+        for (size_t i = Size(); i-- > 0;) {
+            if (flags[i]) {
+                RemoveAt(i);
+            }
+        }
+    }
+
+private:
+    // Gives row i (already allocated) a slot from the free list
+    void AcquireRow(size_t i) {
+        const uint32_t s = freeSlots.back();
+        freeSlots.pop_back();
+        slotToIndex[s] = static_cast<uint32_t>(i);
+        slot[i] = s;
+        stats.acquired++;
+    }
+
+    // New asteroid entering from a random edge, aimed near the centre
+    void WriteSpawnRow(size_t i, int screenW, int screenH, AsteroidShape shape, Rng& rng) {
+        const int k = (shape == AsteroidShape::RANDOM)
+            ? rng.Int(0, ASTEROID_KIND_COUNT - 1)
+            : static_cast<int>(shape);
+        const AsteroidKindTraits& traits = ASTEROID_KINDS[k];
+
+        int sz = 1 << rng.Int(0, 2);
+        float r = RadiusOf(sz);
+
+        // All continuous parameters in one batch
+        enum { U_EDGE, U_ANGLE, U_OFFSET, U_SPEED, U_ROT_SPEED, U_ROT, U_COUNT };
+        float u[U_COUNT];
+        rng.FillFloats(u, U_COUNT, 0.f, 1.f);
+
+        Vector2 pos;
+        switch (rng.Int(0, 3)) {
+        case 0:
+            pos = { u[U_EDGE] * screenW, -r };
+            break;
+        case 1:
+            pos = { screenW + r, u[U_EDGE] * screenH };
+            break;
+        case 2:
+            pos = { u[U_EDGE] * screenW, screenH + r };
+            break;
+        default:
+            pos = { -r, u[U_EDGE] * screenH };
+            break;
+        }
+
+        float maxOff = fminf(screenW, screenH) * 0.1f;
+        float ang = u[U_ANGLE] * 2 * PI;
+        float rad = u[U_OFFSET] * maxOff;
+        Vector2 center = {
+            screenW * 0.5f + cosf(ang) * rad,
+            screenH * 0.5f + sinf(ang) * rad
+        };
+
+        Vector2 dir = Vector2Normalize(Vector2Subtract(center, pos));
+        Vector2 vel = Vector2Scale(dir, SPEED_MIN + u[U_SPEED] * (SPEED_MAX - SPEED_MIN));
+        float rotSpeed = ROT_MIN + u[U_ROT_SPEED] * (ROT_MAX - ROT_MIN);
+        float rot = u[U_ROT] * 360;
+
+        int startHP = traits.baseHP * sz;
+
+        posX[i] = pos.x;
+        posY[i] = pos.y;
+        velX[i] = vel.x;
+        velY[i] = vel.y;
+        rotation[i] = rot;
+        rotationSpeed[i] = rotSpeed;
+        radius[i] = r;
+        hp[i] = startHP;
+        maxHP[i] = startHP;
+        damage[i] = traits.baseDamage * sz;
+        size[i] = static_cast<uint8_t>(sz);
+        kind[i] = static_cast<uint8_t>(k);
+    }
+
+    bool IsFreeSlot(uint32_t s) const {
+        return slotToIndex[s] == FREE_MARK;
+    }
+
+    template <typename Fn>
+    void ForEachArray(Fn&& fn) {
+        fn(posX); fn(posY); fn(velX); fn(velY);
+        fn(rotation); fn(rotationSpeed); fn(radius);
+        fn(hp); fn(maxHP); fn(damage);
+        fn(size); fn(kind); fn(slot);
+    }
+
+    template <typename Self, typename Fn>
+    static void ForEachColumnOf(Self& self, Fn& fn) {
+        fn(self.posX); fn(self.posY); fn(self.velX); fn(self.velY);
+        fn(self.rotation); fn(self.rotationSpeed); fn(self.radius);
+        fn(self.hp); fn(self.maxHP); fn(self.damage);
+        fn(self.size); fn(self.kind); fn(self.slot);
+        fn(self.slotToIndex); fn(self.slotGeneration); fn(self.freeSlots);
+    }
+
+    static constexpr uint32_t FREE_MARK = 0xFFFFFFFFu;
+
+    std::vector<uint32_t> slotToIndex;
+    std::vector<uint32_t> slotGeneration;
+    std::vector<uint32_t> freeSlots;
+    PoolStats             stats;
+
+    static constexpr float SPEED_MIN = 20.f;
+    static constexpr float SPEED_MAX = 120.f;
+    static constexpr float ROT_MIN = 40.f;
+    static constexpr float ROT_MAX = 150.f;
+};
+
+// Fragments of the asteroids destroyed during a collision pass. They are
+// queued while the pass still indexes the store and inserted in one batch
+// after it. Init() reserves the whole queue up front; pieces past that in
+// one tick are dropped and counted instead of growing it mid-frame.
+class FragmentQueue {
+public:
+    void Init(size_t capacity) {
+        items.clear();
+        items.reserve(capacity);
+    }
+
+    // Queues the pieces of asteroid i: LARGE breaks into two MEDIUM, MEDIUM
+    // into two SMALL, SMALL leaves nothing. Pieces keep the parent's kind and
+    // fly off its heading, turned apart and slightly faster.
+    void Split(const AsteroidStore& asteroids, size_t i, Rng& rng) {
+        const int sz = asteroids.size[i];
+        if (sz <= Renderable::SMALL) return;
+        const int childSize = sz / 2;
+        const Vector2 vel = { asteroids.velX[i], asteroids.velY[i] };
+        const float speed = Vector2Length(vel);
+        const Vector2 dir = speed > 0.f ? Vector2Scale(vel, 1.f / speed) : Vector2{ 1.f, 0.f };
+        const float offset = AsteroidStore::RadiusOf(childSize);
+
+        for (int side = -1; side <= 1; side += 2) {
+            if (items.size() == items.capacity()) {
+                dropped++;
+                continue;
+            }
+            enum { U_SPREAD, U_SPEED, U_ROT, U_ROT_SPEED, U_COUNT };
+            float u[U_COUNT];
+            rng.FillFloats(u, U_COUNT, 0.f, 1.f);
+            const float turn = side * (SPREAD_MIN + u[U_SPREAD] * (SPREAD_MAX - SPREAD_MIN));
+            const Vector2 v = Vector2Scale(Vector2Rotate(vel, turn), SPEEDUP_MIN + u[U_SPEED] * (SPEEDUP_MAX - SPEEDUP_MIN));
+            // Side by side across the heading, so the pieces start apart
+            const Vector2 pos = {
+                asteroids.posX[i] - dir.y * offset * side,
+                asteroids.posY[i] + dir.x * offset * side
+            };
+            items.push_back({ pos.x, pos.y, v.x, v.y, u[U_ROT] * 360.f,
+                side * asteroids.rotationSpeed[i] * (1.f + u[U_ROT_SPEED]),
+                static_cast<uint8_t>(childSize), asteroids.kind[i] });
+        }
+    }
+
+    const AsteroidFragment* Data() const {
+        return items.data();
+    }
+
+    size_t Size() const {
+        return items.size();
+    }
+
+    void Clear() {
+        items.clear();
+    }
+
+    uint64_t Dropped() const {
+        return dropped;
+    }
+
+private:
+    static constexpr float SPREAD_MIN = 15.f * DEG2RAD;
+    static constexpr float SPREAD_MAX = 45.f * DEG2RAD;
+    static constexpr float SPEEDUP_MIN = 1.0f;
+    static constexpr float SPEEDUP_MAX = 1.4f;
+
+    std::vector<AsteroidFragment> items;
+    uint64_t                      dropped = 0;
+};
+
+// --- PROJECTILE HIERARCHY ---
+enum class WeaponType { LASER, BULLET, SIDE_BLASTER, HOMING, COUNT };
+
+
+// Weapon patterns as data: what one trigger pull emits. Directions are scaled by
+// the ship's projectile speed. Adding a shot to a pattern is a table edit.
+struct ShotSpec {
+    float dirX;
+    float dirY;
+    int   damage;
+};
+
+struct WeaponPattern {
+    int      shotCount;
+    ShotSpec shots[2];
+};
+
+static constexpr WeaponPattern WEAPON_PATTERNS[] = {
+    /* LASER        */ { 1, { { 0.f, -1.f, 10 } } },
+    /* BULLET       */ { 1, { { 0.f, -1.f, 3 } } },
+    /* SIDE_BLASTER */ { 2, { { -1.f, 0.f, 5 }, { 1.f, 0.f, 5 } } },
+    /* HOMING       */ { 1, { { 0.f, -1.f, 6 } } }, // launched upward, steered by the simulation
+};
+static_assert(sizeof(WEAPON_PATTERNS) / sizeof(WEAPON_PATTERNS[0]) == static_cast<size_t>(WeaponType::COUNT),
+    "one pattern per weapon");
+
+static inline float ProjectileRadius(WeaponType wt) {
+    switch (wt) {
+    case WeaponType::BULLET: return 5.f;
+    case WeaponType::HOMING: return 3.f;
+    default: return 2.f;
+    }
+}
+
+// Projectile sprites, rasterised once at startup into the atlas with the shapes
+// and colours the geometry path used: a 4x30 blue laser ending at the
+// projectile, a white r=5 bullet and a green r=10 triangle centred on it.
+// The homing missile, which never had a geometry path, is an orange r=3 dot.
+struct ProjectileSprites {
+    SpriteHandle handle[static_cast<int>(WeaponType::COUNT)];
+    Vector2      anchor[static_cast<int>(WeaponType::COUNT)]; // sprite pixel placed on the projectile
+    Rectangle    src[static_cast<int>(WeaponType::COUNT)];
+
+    void Register(AssetCache& assets) {
+        static constexpr float LASER_LENGTH = 30.f;
+        static constexpr float BULLET_RADIUS = 5.f;
+        static constexpr float BLASTER_RADIUS = 10.f;
+        static constexpr float HOMING_RADIUS = 3.5f;
+        Add(assets, WeaponType::LASER, "projectile_laser", 4, static_cast<int>(LASER_LENGTH), { 2.f, LASER_LENGTH }, BLUE,
+            [](float, float) { return true; });
+        Add(assets, WeaponType::BULLET, "projectile_bullet", 11, 11, { 5.5f, 5.5f }, WHITE,
+            [](float x, float y) { return x * x + y * y <= BULLET_RADIUS * BULLET_RADIUS; });
+        Add(assets, WeaponType::SIDE_BLASTER, "projectile_side_blaster", 18, 15, { 9.f, BLASTER_RADIUS }, GREEN,
+            [](float x, float y) {
+                // apex up, base at y = r/2, same vertices as the old triangle
+                const float halfBase = BLASTER_RADIUS * 0.866f;
+                const float t = (y + BLASTER_RADIUS) / (1.5f * BLASTER_RADIUS);
+                return t >= 0.f && t <= 1.f && fabsf(x) <= halfBase * t;
+            });
+        Add(assets, WeaponType::HOMING, "projectile_homing", 7, 7, { 3.5f, 3.5f }, ORANGE,
+            [](float x, float y) { return x * x + y * y <= HOMING_RADIUS * HOMING_RADIUS; });
+    }
+
+    // Atlas rectangles are known once the atlas is built
+    void Resolve(const AssetCache& assets) {
+        for (int i = 0; i < static_cast<int>(WeaponType::COUNT); ++i) {
+            src[i] = assets.SourceRect(handle[i]);
+        }
+    }
+
+private:
+    // inside(x, y) is tested at pixel centres relative to the anchor
+    template <typename Inside>
+    void Add(AssetCache& assets, WeaponType type, const char* name, int w, int h, Vector2 a, Color color, Inside inside) {
+        Image image = GenImageColor(w, h, BLANK);
+        for (int py = 0; py < h; ++py) {
+            for (int px = 0; px < w; ++px) {
+                if (inside(px + 0.5f - a.x, py + 0.5f - a.y)) ImageDrawPixel(&image, px, py, color);
+            }
+        }
+        const int i = static_cast<int>(type);
+        handle[i] = assets.AddSprite(name, image);
+        anchor[i] = a;
+    }
+};
+
+static inline void QueueProjectile(Renderer& renderer, const ProjectileSprites& sprites, Vector2 pos, WeaponType type) {
+    const int i = static_cast<int>(type);
+    const Rectangle& src = sprites.src[i];
+    Rectangle dst = { pos.x - sprites.anchor[i].x, pos.y - sprites.anchor[i].y, src.width, src.height };
+    renderer.QueueSprite(src, dst, WHITE, Renderer::LAYER_PROJECTILES);
+}
+
+// Structure-of-arrays projectile storage, same layout rules as AsteroidStore
+struct ProjectileStore {
+    std::vector<float>   posX;
+    std::vector<float>   posY;
+    std::vector<float>   prevX; // start of the current tick, for swept tests
+    std::vector<float>   prevY;
+    std::vector<float>   velX;
+    std::vector<float>   velY;
+    std::vector<float>   radius;
+    std::vector<int>     damage;
+    std::vector<uint8_t> type; // WeaponType
+    std::vector<AsteroidHandle> target; // HOMING only: asteroid being chased, null until acquired
+
+    // Sizes the arrays once; emission never grows them past this
+    void Init(size_t cap) {
+        capacity = cap;
+        ForEachArray([cap](auto& arr) {
+            arr.clear();
+            arr.reserve(cap);
+        });
+    }
+
+    size_t Size() const {
+        return posX.size();
+    }
+
+    size_t Capacity() const {
+        return capacity;
+    }
+
+    // Shots dropped because the store was full
+    uint64_t Dropped() const {
+        return dropped;
+    }
+
+    void Clear() {
+        ForEachArray([](auto& arr) { arr.clear(); });
+    }
+
+    Vector2 GetPosition(size_t i) const {
+        return { posX[i], posY[i] };
+    }
+
+    Vector2 GetPrevPosition(size_t i) const {
+        return { prevX[i], prevY[i] };
+    }
+
+    WeaponType GetType(size_t i) const {
+        return static_cast<WeaponType>(type[i]);
+    }
+
+    // Position of the type column in ForEachColumn order, and the column count
+    enum Column : uint32_t { COLUMN_TYPE = 8, COLUMN_COUNT = 10 };
+
+    // Whether COLUMN_COUNT snapshot columns are rows of one length within cap
+    // with every type a real weapon
+    static bool CheckImage(const ColumnView* columns, size_t cap) {
+        const size_t n = columns[0].count;
+        for (uint32_t c = 0; c < COLUMN_COUNT; ++c) {
+            if (columns[c].count != n) return false;
+        }
+        if (n > cap) return false;
+        const auto* types = static_cast<const uint8_t*>(columns[COLUMN_TYPE].data);
+        for (size_t i = 0; i < n; ++i) {
+            if (types[i] >= static_cast<uint8_t>(WeaponType::COUNT)) return false;
+        }
+        return true;
+    }
+
+    // Every array of the store, for flat world snapshots
+    template <typename Fn>
+    void ForEachColumn(Fn&& fn) {
+        ForEachArray(fn);
+    }
+
+    template <typename Fn>
+    void ForEachColumn(Fn&& fn) const {
+        fn(posX); fn(posY); fn(prevX); fn(prevY); fn(velX); fn(velY);
+        fn(radius); fn(damage); fn(type); fn(target);
+    }
+
+    // Writes one trigger pull of the weapon's pattern straight into the arrays
+    void Emit(WeaponType wt, Vector2 pos, float speed) {
+        const WeaponPattern& pattern = WEAPON_PATTERNS[static_cast<int>(wt)];
+        const float r = ProjectileRadius(wt);
+        for (int s = 0; s < pattern.shotCount; ++s) {
+            if (Size() >= capacity) {
+                dropped += pattern.shotCount - s;
+                return;
+            }
+            const ShotSpec& shot = pattern.shots[s];
+            posX.push_back(pos.x);
+            posY.push_back(pos.y);
+            prevX.push_back(pos.x);
+            prevY.push_back(pos.y);
+            velX.push_back(shot.dirX * speed);
+            velY.push_back(shot.dirY * speed);
+            radius.push_back(r);
+            damage.push_back(shot.damage);
+            type.push_back(static_cast<uint8_t>(wt));
+            target.push_back(AsteroidHandle{});
+        }
+    }
+
+    void RemoveAt(size_t i) {
+        ForEachArray([i](auto& arr) {
+            arr[i] = arr.back();
+            arr.pop_back();
+        });
+    }
+
+    void RemoveFlagged(const std::vector<uint8_t>& flags) {
+        for (size_t i = Size(); i-- > 0;) {
+            if (flags[i]) {
+                RemoveAt(i);
+            }
+        }
+    }
+
+private:
+    template <typename Fn>
+    void ForEachArray(Fn&& fn) {
+        fn(posX); fn(posY); fn(prevX); fn(prevY); fn(velX); fn(velY);
+        fn(radius); fn(damage); fn(type); fn(target);
+    }
+
+    size_t   capacity = 0;
+    uint64_t dropped = 0;
+};
+
+// --- BROADPHASE ---
+// Swept narrowphase: does the segment p0->p1 come within r of c? On a hit, t is
+// the earliest parameter in [0, 1] at which it does (0 if p0 already overlaps).
+// Asteroids are tested at their start-of-tick positions; they move after this pass.
+static inline bool SweptCircleHit(Vector2 p0, Vector2 p1, Vector2 c, float r, float& t) {
+    const Vector2 d = Vector2Subtract(p1, p0);
+    const Vector2 f = Vector2Subtract(p0, c);
+    const float cc = Vector2DotProduct(f, f) - r * r;
+    if (cc < 0.f) {
+        t = 0.f;
+        return true;
+    }
+    const float a = Vector2DotProduct(d, d);
+    if (a <= 0.f) {
+        return false;
+    }
+    const float b = Vector2DotProduct(f, d);
+    const float disc = b * b - a * cc;
+    if (disc <= 0.f) {
+        return false;
+    }
+    t = (-b - sqrtf(disc)) / a;
+    return t >= 0.f && t <= 1.f;
+}
+
+// Uniform grid over the play field, rebuilt every frame. Each asteroid is binned
+// into every cell its bounding box touches, so a projectile only has to look at
+// the cells under its own bounding box. Cell lists are stored back to back
+// (counting sort), in ascending asteroid index.
+class CollisionGrid {
+public:
+    void Build(const AsteroidStore& asteroids, int screenW, int screenH) {
+        const int n = static_cast<int>(asteroids.Size());
+        float maxRadius = 0.f;
+        for (int i = 0; i < n; ++i) {
+            maxRadius = fmaxf(maxRadius, asteroids.radius[i]);
+        }
+        cellSize = fmaxf(2.f * maxRadius, MIN_CELL_SIZE);
+        invCellSize = 1.f / cellSize;
+        // One ring of border cells on each side catches asteroids entering from off-screen
+        originX = -cellSize;
+        originY = -cellSize;
+        cols = static_cast<int>(ceilf((screenW + 2.f * cellSize) * invCellSize));
+        rows = static_cast<int>(ceilf((screenH + 2.f * cellSize) * invCellSize));
+
+        cellStart.assign(static_cast<size_t>(cols) * rows + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            ForEachCell(asteroids.GetPosition(i), asteroids.radius[i], [this](int cell) {
+                cellStart[cell + 1]++;
+            });
+        }
+        for (size_t c = 1; c < cellStart.size(); ++c) {
+            cellStart[c] += cellStart[c - 1];
+        }
+
+        items.resize(cellStart.back());
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        firstCellX.resize(n);
+        firstCellY.resize(n);
+        for (int i = 0; i < n; ++i) {
+            firstCellX[i] = CellCoord(asteroids.posX[i] - asteroids.radius[i] - originX, cols);
+            firstCellY[i] = CellCoord(asteroids.posY[i] - asteroids.radius[i] - originY, rows);
+            ForEachCell(asteroids.GetPosition(i), asteroids.radius[i], [this, i](int cell) {
+                items[cursor[cell]++] = i;
+            });
+        }
+    }
+
+    // Earliest live asteroid hit by a circle swept from p0 to p1, or -1. Ties on
+    // t go to the lowest index, so the result matches the brute-force scan.
+    int QueryEarliest(const AsteroidStore& asteroids, const std::vector<uint8_t>& dead,
+        Vector2 p0, Vector2 p1, float radius) const {
+        int best = -1;
+        float bestT = 0.f;
+        ForEachCell(fminf(p0.x, p1.x) - radius, fminf(p0.y, p1.y) - radius,
+            fmaxf(p0.x, p1.x) + radius, fmaxf(p0.y, p1.y) + radius, [&](int cell) {
+            for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                int idx = items[k];
+                float t;
+                if (dead[idx] || !SweptCircleHit(p0, p1, asteroids.GetPosition(idx), radius + asteroids.radius[idx], t)) {
+                    continue;
+                }
+                if (best < 0 || t < bestT || (t == bestT && idx < best)) {
+                    best = idx;
+                    bestT = t;
+                }
+            }
+        });
+        return best;
+    }
+
+    // Calls fn(i) once for every asteroid whose box touches the square of half
+    // size radius around pos. An asteroid binned into several cells is only
+    // reported from the first of them that the query covers.
+    template <typename Fn>
+    void ForEachNear(const AsteroidStore& asteroids, Vector2 pos, float radius, Fn&& fn) const {
+        const int qx0 = CellCoord(pos.x - radius - originX, cols);
+        const int qy0 = CellCoord(pos.y - radius - originY, rows);
+        ForEachCell(pos, radius, [&](int cell) {
+            const int cx = cell % cols;
+            const int cy = cell / cols;
+            for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                const int idx = items[k];
+                if (std::max(firstCellX[idx], qx0) != cx || std::max(firstCellY[idx], qy0) != cy) {
+                    continue;
+                }
+                const float reach = radius + asteroids.radius[idx];
+                if (fabsf(asteroids.posX[idx] - pos.x) <= reach && fabsf(asteroids.posY[idx] - pos.y) <= reach) {
+                    fn(static_cast<size_t>(idx));
+                }
+            }
+        });
+    }
+
+private:
+    template <typename Fn>
+    void ForEachCell(Vector2 pos, float radius, Fn&& fn) const {
+        ForEachCell(pos.x - radius, pos.y - radius, pos.x + radius, pos.y + radius, fn);
+    }
+
+    template <typename Fn>
+    void ForEachCell(float minX, float minY, float maxX, float maxY, Fn&& fn) const {
+        // Clamping is monotonic, so overlapping boxes still share a cell at the borders
+        int x0 = CellCoord(minX - originX, cols);
+        int x1 = CellCoord(maxX - originX, cols);
+        int y0 = CellCoord(minY - originY, rows);
+        int y1 = CellCoord(maxY - originY, rows);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                fn(y * cols + x);
+            }
+        }
+    }
+
+    int CellCoord(float offset, int count) const {
+        int c = static_cast<int>(floorf(offset * invCellSize));
+        return std::clamp(c, 0, count - 1);
+    }
+
+    static constexpr float MIN_CELL_SIZE = 32.f;
+
+    float cellSize = MIN_CELL_SIZE;
+    float invCellSize = 1.f / MIN_CELL_SIZE;
+    float originX = 0.f;
+    float originY = 0.f;
+    int   cols = 0;
+    int   rows = 0;
+
+    std::vector<int> cellStart;
+    std::vector<int> cursor;
+    std::vector<int> items;
+    std::vector<int> firstCellX; // per asteroid, its top-left cell
+    std::vector<int> firstCellY;
+};
+
+// Sweep-and-prune along x for asteroid-vs-ship and asteroid-vs-asteroid tests.
+// Entries follow asteroids by pool slot from tick to tick, so the list is
+// already nearly sorted and an insertion sort brings it back in close to linear
+// time; newcomers are sorted on their own and merged in. The key is
+// (minX, slot), a total order, so the sorted list depends only on the current
+// field and never on its history.
+class SweepAndPrune {
+public:
+    void Clear() {
+        entries.clear();
+        std::fill(listed.begin(), listed.end(), 0);
+    }
+
+    bool Empty() const {
+        return entries.empty();
+    }
+
+    // Refreshes every interval from the store's current positions and re-sorts
+    void Update(const AsteroidStore& asteroids) {
+        const size_t capacity = asteroids.Capacity();
+        if (rowOfSlot.size() != capacity) {
+            entries.clear();
+            rowOfSlot.assign(capacity, 0);
+            seenEpoch.assign(capacity, 0);
+            listed.assign(capacity, 0);
+        }
+        epoch++;
+        const size_t n = asteroids.Size();
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t s = asteroids.slot[i];
+            rowOfSlot[s] = static_cast<uint32_t>(i);
+            seenEpoch[s] = epoch;
+        }
+
+        // Keep the surviving entries in their old order, drop released slots
+        maxWidth = 0.f;
+        size_t kept = 0;
+        for (const Entry& old : entries) {
+            if (seenEpoch[old.slot] != epoch) {
+                listed[old.slot] = 0;
+                continue;
+            }
+            Entry& e = entries[kept++];
+            e = old;
+            SetBounds(e, asteroids, rowOfSlot[e.slot]);
+        }
+        entries.resize(kept);
+        InsertionSort(entries);
+
+        incoming.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t s = asteroids.slot[i];
+            if (listed[s]) continue;
+            listed[s] = 1;
+            Entry e{ 0.f, 0.f, 0.f, 0.f, s, 0 };
+            SetBounds(e, asteroids, static_cast<uint32_t>(i));
+            incoming.push_back(e);
+        }
+        if (!incoming.empty()) {
+            std::sort(incoming.begin(), incoming.end(), Less);
+            merged.resize(entries.size() + incoming.size());
+            std::merge(entries.begin(), entries.end(), incoming.begin(), incoming.end(), merged.begin(), Less);
+            entries.swap(merged);
+        }
+    }
+
+    // Rows whose x interval overlaps [minX, maxX], in sweep order
+    template <typename Fn>
+    void QueryX(float minX, float maxX, Fn&& fn) const {
+        // Nothing that starts further left than minX - maxWidth can reach minX
+        auto it = std::lower_bound(entries.begin(), entries.end(), minX - maxWidth,
+            [](const Entry& e, float x) { return e.minX < x; });
+        for (; it != entries.end() && it->minX <= maxX; ++it) {
+            if (it->maxX >= minX) {
+                fn(it->row);
+            }
+        }
+    }
+
+    // Every pair of rows whose bounding boxes overlap, in sweep order
+    template <typename Fn>
+    void ForEachOverlap(Fn&& fn) const {
+        const size_t n = entries.size();
+        for (size_t i = 0; i < n; ++i) {
+            const Entry& a = entries[i];
+            for (size_t j = i + 1; j < n && entries[j].minX <= a.maxX; ++j) {
+                const Entry& b = entries[j];
+                if (b.minY <= a.maxY && a.minY <= b.maxY) {
+                    fn(a.row, b.row);
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        float    minX;
+        float    maxX;
+        float    minY; // y extent rides along so the pair sweep stays in the list
+        float    maxY;
+        uint32_t slot;
+        uint32_t row; // dense index this tick
+    };
+
+    static bool Less(const Entry& a, const Entry& b) {
+        return a.minX < b.minX || (a.minX == b.minX && a.slot < b.slot);
+    }
+
+    void SetBounds(Entry& e, const AsteroidStore& asteroids, uint32_t row) {
+        const float r = asteroids.radius[row];
+        e.minX = asteroids.posX[row] - r;
+        e.maxX = asteroids.posX[row] + r;
+        e.minY = asteroids.posY[row] - r;
+        e.maxY = asteroids.posY[row] + r;
+        e.row = row;
+        maxWidth = fmaxf(maxWidth, 2.f * r);
+    }
+
+    static void InsertionSort(std::vector<Entry>& v) {
+        for (size_t i = 1; i < v.size(); ++i) {
+            if (!Less(v[i], v[i - 1])) continue;
+            Entry e = v[i];
+            size_t j = i;
+            do {
+                v[j] = v[j - 1];
+                --j;
+            } while (j > 0 && Less(e, v[j - 1]));
+            v[j] = e;
+        }
+    }
+
+    std::vector<Entry>    entries;  // sorted by (minX, slot)
+    std::vector<Entry>    incoming; // asteroids spawned since the last update
+    std::vector<Entry>    merged;
+    std::vector<uint32_t> rowOfSlot;
+    std::vector<uint32_t> seenEpoch;
+    std::vector<uint8_t>  listed;   // slot has an entry
+    uint32_t              epoch = 0;
+    float                 maxWidth = 0.f;
+};
+
+// Bounding volume hierarchy over asteroid centres for nearest, k-nearest and
+// radius queries. Points are kept in Morton (Z-curve) order of their position
+// and every node covers a halving range of that order, so the tree needs no
+// pointers (children of n at 2n+1 and 2n+2) and leaves hold up to LEAF_SIZE
+// points. Like the sweep, points follow asteroids by pool slot from tick to
+// tick: the order is nearly sorted already, an insertion sort repairs it and
+// newcomers are merged in, after which node boxes are refitted bottom up.
+// Equal distances go to the lowest row, so answers depend only on the field.
+class AsteroidBvh {
+public:
+    static constexpr int MAX_K = 16;
+
+    // Forgets the order, e.g. when the store was replaced wholesale
+    void Clear() {
+        points.clear();
+        std::fill(listed.begin(), listed.end(), 0);
+    }
+
+    // Sizes everything for a full pool, so updates never allocate
+    void Reserve(size_t capacity) {
+        points.clear();
+        points.reserve(capacity);
+        incoming.reserve(capacity);
+        merged.reserve(capacity);
+        boxes.resize(NodeCount(capacity));
+        rowOfSlot.assign(capacity, 0);
+        seenEpoch.assign(capacity, 0);
+        listed.assign(capacity, 0);
+    }
+
+    // Brings the order and every box up to the store's current positions
+    void Update(const AsteroidStore& asteroids) {
+        if (rowOfSlot.size() != asteroids.Capacity()) {
+            Reserve(asteroids.Capacity());
+        }
+        epoch++;
+        const size_t n = asteroids.Size();
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t s = asteroids.slot[i];
+            rowOfSlot[s] = static_cast<uint32_t>(i);
+            seenEpoch[s] = epoch;
+        }
+
+        size_t kept = 0;
+        for (const Point& old : points) {
+            if (seenEpoch[old.slot] != epoch) {
+                listed[old.slot] = 0;
+                continue;
+            }
+            Point& p = points[kept++];
+            p.slot = old.slot;
+            SetPosition(p, asteroids, rowOfSlot[p.slot]);
+        }
+        points.resize(kept);
+        InsertionSort(points);
+
+        incoming.clear();
+        for (size_t i = 0; i < n; ++i) {
+            const uint32_t s = asteroids.slot[i];
+            if (listed[s]) continue;
+            listed[s] = 1;
+            Point p{ 0.f, 0.f, 0, 0, s };
+            SetPosition(p, asteroids, static_cast<uint32_t>(i));
+            incoming.push_back(p);
+        }
+        if (!incoming.empty()) {
+            std::sort(incoming.begin(), incoming.end(), Less);
+            merged.resize(points.size() + incoming.size());
+            std::merge(points.begin(), points.end(), incoming.begin(), incoming.end(), merged.begin(), Less);
+            points.swap(merged);
+        }
+        if (!points.empty()) {
+            Refit(0, 0, points.size());
+        }
+    }
+
+    bool Empty() const {
+        return points.empty();
+    }
+
+    // Row of the asteroid whose centre is nearest (x, y), or -1 if there is none
+    int Nearest(float x, float y) const {
+        Best best;
+        if (!points.empty()) {
+            NearestIn(0, 0, points.size(), x, y, best);
+        }
+        return best.at == NONE ? -1 : static_cast<int>(points[best.at].row);
+    }
+
+    // Nearest row for each of count queries, or -1 where nothing is closer than
+    // sqrt(limitSq[q]). A tight limit prunes most of the tree up front, and since
+    // consecutive queries tend to be close (projectiles leave the guns in
+    // streams), each search also starts from the previous answer.
+    void NearestBatch(const float* qx, const float* qy, const float* limitSq, size_t count, int* out) const {
+        uint32_t prev = NONE;
+        for (size_t q = 0; q < count; ++q) {
+            Best best;
+            best.distSq = limitSq[q];
+            if (prev != NONE) {
+                const float d = DistSq(points[prev], qx[q], qy[q]);
+                if (d < best.distSq) {
+                    best.at = prev;
+                    best.distSq = d;
+                }
+            }
+            if (!points.empty()) {
+                NearestIn(0, 0, points.size(), qx[q], qy[q], best);
+            }
+            prev = best.at;
+            out[q] = best.at == NONE ? -1 : static_cast<int>(points[best.at].row);
+        }
+    }
+
+    // Up to k (at most MAX_K) nearest rows, closest first; returns how many
+    int KNearest(float x, float y, int k, int* out) const {
+        KBest kb;
+        kb.k = std::clamp(k, 0, MAX_K);
+        if (kb.k > 0 && !points.empty()) {
+            KNearestIn(0, 0, points.size(), x, y, kb);
+        }
+        for (int i = 0; i < kb.count; ++i) {
+            out[i] = static_cast<int>(points[kb.at[i]].row);
+        }
+        return kb.count;
+    }
+
+    // Every row whose centre lies within radius of (x, y), in no particular order
+    template <typename Fn>
+    void Radius(float x, float y, float radius, Fn&& fn) const {
+        if (!points.empty()) {
+            RadiusIn(0, 0, points.size(), x, y, radius * radius, fn);
+        }
+    }
+
+private:
+    struct Point {
+        float    x;
+        float    y;
+        uint32_t key; // Morton code of the quantised position
+        uint32_t row; // dense index this tick
+        uint32_t slot;
+    };
+
+    struct Box {
+        float minX;
+        float minY;
+        float maxX;
+        float maxY;
+    };
+
+    struct Best {
+        uint32_t at = NONE; // index into points
+        float    distSq = INFINITY; // exclusive while at is NONE
+    };
+
+    struct KBest {
+        int      k = 0;
+        int      count = 0;
+        uint32_t at[MAX_K];
+        float    distSq[MAX_K];
+
+        float Bound() const {
+            return count < k ? INFINITY : distSq[count - 1];
+        }
+    };
+
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+    static constexpr size_t LEAF_SIZE = 16;
+    static constexpr float KEY_ORIGIN = -1024.f; // keys cover [-1024, 64511) px at 1 px per step
+
+    static bool Less(const Point& a, const Point& b) {
+        return a.key < b.key || (a.key == b.key && a.slot < b.slot);
+    }
+
+    // Ranges halve until they fit a leaf, the larger half rounding up
+    static size_t NodeCount(size_t n) {
+        size_t nodes = 1;
+        while (n > LEAF_SIZE) {
+            n = (n + 1) / 2;
+            nodes = nodes * 2 + 1;
+        }
+        return nodes;
+    }
+
+    static uint32_t SpreadBits(uint32_t v) {
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    }
+
+    static uint32_t Quantise(float v) {
+        return static_cast<uint32_t>(std::clamp(v - KEY_ORIGIN, 0.f, 65535.f));
+    }
+
+    static void SetPosition(Point& p, const AsteroidStore& asteroids, uint32_t row) {
+        p.x = asteroids.posX[row];
+        p.y = asteroids.posY[row];
+        p.row = row;
+        p.key = SpreadBits(Quantise(p.x)) | (SpreadBits(Quantise(p.y)) << 1);
+    }
+
+    static void InsertionSort(std::vector<Point>& v) {
+        for (size_t i = 1; i < v.size(); ++i) {
+            if (!Less(v[i], v[i - 1])) continue;
+            Point p = v[i];
+            size_t j = i;
+            do {
+                v[j] = v[j - 1];
+                --j;
+            } while (j > 0 && Less(p, v[j - 1]));
+            v[j] = p;
+        }
+    }
+
+    static float DistSq(const Point& p, float x, float y) {
+        const float dx = p.x - x;
+        const float dy = p.y - y;
+        return dx * dx + dy * dy;
+    }
+
+    // Lower bound on the distance from (x, y) to anything in the box
+    static float BoxDistSq(const Box& b, float x, float y) {
+        const float dx = fmaxf(fmaxf(b.minX - x, x - b.maxX), 0.f);
+        const float dy = fmaxf(fmaxf(b.minY - y, y - b.maxY), 0.f);
+        return dx * dx + dy * dy;
+    }
+
+    // Distance first, then row. With no best yet, bestDistSq is an exclusive limit.
+    bool Closer(float distSq, uint32_t at, float bestDistSq, uint32_t bestAt) const {
+        return distSq < bestDistSq || (distSq == bestDistSq && bestAt != NONE && points[at].row < points[bestAt].row);
+    }
+
+    const Box& Refit(size_t node, size_t lo, size_t hi) {
+        Box& b = boxes[node];
+        if (hi - lo <= LEAF_SIZE) {
+            b = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+            for (size_t i = lo; i < hi; ++i) {
+                b.minX = fminf(b.minX, points[i].x);
+                b.minY = fminf(b.minY, points[i].y);
+                b.maxX = fmaxf(b.maxX, points[i].x);
+                b.maxY = fmaxf(b.maxY, points[i].y);
+            }
+            return b;
+        }
+        const size_t mid = lo + (hi - lo) / 2;
+        const Box& l = Refit(2 * node + 1, lo, mid);
+        const Box& r = Refit(2 * node + 2, mid, hi);
+        b = { fminf(l.minX, r.minX), fminf(l.minY, r.minY), fmaxf(l.maxX, r.maxX), fmaxf(l.maxY, r.maxY) };
+        return b;
+    }
+
+    // Nearer child first; ties are kept, since a point at equal distance in the
+    // other child may have a lower row
+    void NearestIn(size_t node, size_t lo, size_t hi, float x, float y, Best& best) const {
+        if (hi - lo <= LEAF_SIZE) {
+            for (size_t i = lo; i < hi; ++i) {
+                const float d = DistSq(points[i], x, y);
+                if (Closer(d, static_cast<uint32_t>(i), best.distSq, best.at)) {
+                    best.at = static_cast<uint32_t>(i);
+                    best.distSq = d;
+                }
+            }
+            return;
+        }
+        const size_t mid = lo + (hi - lo) / 2;
+        const float dl = BoxDistSq(boxes[2 * node + 1], x, y);
+        const float dr = BoxDistSq(boxes[2 * node + 2], x, y);
+        if (dl <= dr) {
+            if (dl <= best.distSq) NearestIn(2 * node + 1, lo, mid, x, y, best);
+            if (dr <= best.distSq) NearestIn(2 * node + 2, mid, hi, x, y, best);
+        }
+        else {
+            if (dr <= best.distSq) NearestIn(2 * node + 2, mid, hi, x, y, best);
+            if (dl <= best.distSq) NearestIn(2 * node + 1, lo, mid, x, y, best);
+        }
+    }
+
+    void KNearestIn(size_t node, size_t lo, size_t hi, float x, float y, KBest& kb) const {
+        if (hi - lo <= LEAF_SIZE) {
+            for (size_t i = lo; i < hi; ++i) {
+                const float d = DistSq(points[i], x, y);
+                const uint32_t at = static_cast<uint32_t>(i);
+                if (kb.count == kb.k && !Closer(d, at, kb.distSq[kb.count - 1], kb.at[kb.count - 1])) continue;
+                int j = (kb.count < kb.k) ? kb.count++ : kb.count - 1;
+                for (; j > 0 && Closer(d, at, kb.distSq[j - 1], kb.at[j - 1]); --j) {
+                    kb.at[j] = kb.at[j - 1];
+                    kb.distSq[j] = kb.distSq[j - 1];
+                }
+                kb.at[j] = at;
+                kb.distSq[j] = d;
+            }
+            return;
+        }
+        const size_t mid = lo + (hi - lo) / 2;
+        const float dl = BoxDistSq(boxes[2 * node + 1], x, y);
+        const float dr = BoxDistSq(boxes[2 * node + 2], x, y);
+        if (dl <= dr) {
+            if (dl <= kb.Bound()) KNearestIn(2 * node + 1, lo, mid, x, y, kb);
+            if (dr <= kb.Bound()) KNearestIn(2 * node + 2, mid, hi, x, y, kb);
+        }
+        else {
+            if (dr <= kb.Bound()) KNearestIn(2 * node + 2, mid, hi, x, y, kb);
+            if (dl <= kb.Bound()) KNearestIn(2 * node + 1, lo, mid, x, y, kb);
+        }
+    }
+
+    template <typename Fn>
+    void RadiusIn(size_t node, size_t lo, size_t hi, float x, float y, float radiusSq, Fn& fn) const {
+        if (BoxDistSq(boxes[node], x, y) > radiusSq) return;
+        if (hi - lo <= LEAF_SIZE) {
+            for (size_t i = lo; i < hi; ++i) {
+                if (DistSq(points[i], x, y) <= radiusSq) fn(static_cast<int>(points[i].row));
+            }
+            return;
+        }
+        const size_t mid = lo + (hi - lo) / 2;
+        RadiusIn(2 * node + 1, lo, mid, x, y, radiusSq, fn);
+        RadiusIn(2 * node + 2, mid, hi, x, y, radiusSq, fn);
+    }
+
+    std::vector<Point>    points;   // sorted by (key, slot)
+    std::vector<Point>    incoming; // asteroids spawned since the last update
+    std::vector<Point>    merged;
+    std::vector<Box>      boxes;    // per node, over its range of points
+    std::vector<uint32_t> rowOfSlot;
+    std::vector<uint32_t> seenEpoch;
+    std::vector<uint8_t>  listed;   // slot has a point
+    uint32_t              epoch = 0;
+};
+
+// Elastic bounce between two overlapping, approaching asteroids; mass goes
+// with area. Only velocities change, so positions (and any bounds taken from
+// them this tick) stay valid.
+static inline bool BounceAsteroids(AsteroidStore& asteroids, size_t a, size_t b) {
+    const float dx = asteroids.posX[b] - asteroids.posX[a];
+    const float dy = asteroids.posY[b] - asteroids.posY[a];
+    const float reach = asteroids.radius[a] + asteroids.radius[b];
+    const float distSq = dx * dx + dy * dy;
+    if (distSq >= reach * reach || distSq <= 0.f) {
+        return false;
+    }
+    const float dist = sqrtf(distSq);
+    const float nx = dx / dist;
+    const float ny = dy / dist;
+    const float approach = (asteroids.velX[a] - asteroids.velX[b]) * nx + (asteroids.velY[a] - asteroids.velY[b]) * ny;
+    if (approach <= 0.f) {
+        return false; // already separating
+    }
+    const float ma = asteroids.radius[a] * asteroids.radius[a];
+    const float mb = asteroids.radius[b] * asteroids.radius[b];
+    const float j = 2.f * approach / (ma + mb);
+    asteroids.velX[a] -= j * mb * nx;
+    asteroids.velY[a] -= j * mb * ny;
+    asteroids.velX[b] += j * ma * nx;
+    asteroids.velY[b] += j * ma * ny;
+    return true;
+}
+
+// Reference path for A/B checks against the grid
+static inline int FindEarliestHitBruteForce(const AsteroidStore& asteroids,
+    const std::vector<uint8_t>& dead, Vector2 p0, Vector2 p1, float radius) {
+    int best = -1;
+    float bestT = 0.f;
+    for (int i = 0; i < static_cast<int>(asteroids.Size()); ++i) {
+        float t;
+        if (dead[i] || !SweptCircleHit(p0, p1, asteroids.GetPosition(i), radius + asteroids.radius[i], t)) {
+            continue;
+        }
+        if (best < 0 || t < bestT) {
+            best = i;
+            bestT = t;
+        }
+    }
+    return best;
+}
+
+// Reference path for the BVH: nearest centre closer than sqrt(limitSq), lowest
+// row on a tie
+static inline int FindNearestBruteForce(const AsteroidStore& asteroids, float x, float y, float limitSq) {
+    int best = -1;
+    float bestDistSq = limitSq;
+    for (int i = 0; i < static_cast<int>(asteroids.Size()); ++i) {
+        const float dx = asteroids.posX[i] - x;
+        const float dy = asteroids.posY[i] - y;
+        const float d = dx * dx + dy * dy;
+        if (d < bestDistSq) {
+            best = i;
+            bestDistSq = d;
+        }
+    }
+    return best;
+}
+
+// Reference path for the BVH's KNearest: squared distances of the k nearest
+// centres, closest first; returns how many. Checked by distance, since equally
+// far asteroids may be listed in another order.
+static inline int FindKNearestBruteForce(const AsteroidStore& asteroids, float x, float y, int k, float* distSq) {
+    int count = 0;
+    for (size_t i = 0; i < asteroids.Size(); ++i) {
+        const float dx = asteroids.posX[i] - x;
+        const float dy = asteroids.posY[i] - y;
+        const float d = dx * dx + dy * dy;
+        if (count == k && d >= distSq[count - 1]) continue;
+        int j = count < k ? count++ : count - 1;
+        for (; j > 0 && d < distSq[j - 1]; --j) {
+            distSq[j] = distSq[j - 1];
+        }
+        distSq[j] = d;
+    }
+    return count;
+}
+
+// Reference path for the BVH's Radius: every row whose centre lies within radius
+template <typename Fn>
+static inline void ForEachWithinRadiusBruteForce(const AsteroidStore& asteroids, float x, float y, float radius, Fn&& fn) {
+    for (size_t i = 0; i < asteroids.Size(); ++i) {
+        const float dx = asteroids.posX[i] - x;
+        const float dy = asteroids.posY[i] - y;
+        if (dx * dx + dy * dy <= radius * radius) fn(static_cast<int>(i));
+    }
+}
+
+
+// --- INPUT ---
+// One tick worth of player input. The windowed loop samples it from the keyboard,
+// headless runs get it from a script, so the simulation never touches raylib input.
+struct InputState {
+    bool up = false;
+    bool down = false;
+    bool left = false;
+    bool right = false;
+    bool fire = false;
+    bool nextWeapon = false;
+    bool restart = false;
+    bool toggleBroadphase = false;
+    bool toggleBounces = false;
+    int  shapeKey = 0; // 1..5 as on the keyboard, 0 = no change
+    int  spawnLevel = 0; // below SPAWN_LEVELS, asteroid cap lowered by the frame governor; a level, not a press
+
+    static constexpr int SPAWN_LEVELS = 3; // full cap, 75 %, 50 %
+};
+
+static inline InputState PollKeyboard() {
+    InputState in;
+    in.up = IsKeyDown(KEY_W);
+    in.down = IsKeyDown(KEY_S);
+    in.left = IsKeyDown(KEY_A);
+    in.right = IsKeyDown(KEY_D);
+    in.fire = IsKeyDown(KEY_SPACE);
+    in.nextWeapon = IsKeyPressed(KEY_TAB);
+    in.restart = IsKeyPressed(KEY_R);
+    in.toggleBroadphase = IsKeyPressed(KEY_B);
+    in.toggleBounces = IsKeyPressed(KEY_C);
+    if (IsKeyPressed(KEY_ONE)) in.shapeKey = 1;
+    if (IsKeyPressed(KEY_TWO)) in.shapeKey = 2;
+    if (IsKeyPressed(KEY_THREE)) in.shapeKey = 3;
+    if (IsKeyPressed(KEY_FOUR)) in.shapeKey = 4;
+    if (IsKeyPressed(KEY_FIVE)) in.shapeKey = 5;
+    return in;
+}
+
+// Hands keyboard input from the render thread to the simulation thread. Held
+// keys take the latest sample; presses accumulate until the next tick takes
+// them, so a tap between two ticks is not lost.
+class InputLatch {
+public:
+    void Push(const InputState& in) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.up = in.up;
+        pending.down = in.down;
+        pending.left = in.left;
+        pending.right = in.right;
+        pending.fire = in.fire;
+        pending.nextWeapon |= in.nextWeapon;
+        pending.restart |= in.restart;
+        pending.toggleBroadphase ^= in.toggleBroadphase;
+        pending.toggleBounces ^= in.toggleBounces;
+        if (in.shapeKey != 0) pending.shapeKey = in.shapeKey;
+        pending.spawnLevel = in.spawnLevel;
+    }
+
+    InputState Take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        InputState in = pending;
+        pending.nextWeapon = false;
+        pending.restart = false;
+        pending.toggleBroadphase = false;
+        pending.toggleBounces = false;
+        pending.shapeKey = 0;
+        return in;
+    }
+
+private:
+    std::mutex mutex;
+    InputState pending;
+};
+
+// Deterministic stand-in for a player: holds fire, strafes in a square,
+// cycles weapons and restarts after dying.
+class ScriptedInput {
+public:
+    InputState Next(bool playerAlive) {
+        InputState in;
+        int leg = (tick / LEG_TICKS) % 4;
+        in.up = leg == 0;
+        in.right = leg == 1;
+        in.down = leg == 2;
+        in.left = leg == 3;
+        in.fire = true;
+        in.nextWeapon = tick > 0 && tick % WEAPON_TICKS == 0;
+        in.restart = !playerAlive;
+        in.shapeKey = tick == 0 ? 4 : 0; // random shapes
+        ++tick;
+        return in;
+    }
+
+private:
+    long long tick = 0;
+
+    static constexpr int LEG_TICKS = 45;
+    static constexpr int WEAPON_TICKS = 600;
+};
+
+// Per-tick input plus the seed and dt needed to reproduce a run. In memory
+// one 16-bit word per tick; on disk a little-endian header followed by
+// run-length encoded words, since held keys repeat for many ticks.
+//
+//   "ASTR" u32 version, u64 seed, f32 dt, u64 ticks, u32 runs,
+//   runs x { u16 bits, u16 length }
+class InputRecording {
+public:
+    // Launch settings besides seed and dt that change the simulation. A replay
+    // only reproduces the run when they match, so they are stored and checked.
+    struct Settings {
+        uint32_t bots = 0;
+        bool     bounces = false; // asteroid bounces on at the start
+        uint64_t wavesHash = 0;   // FNV-1a of the wave file, 0 without one
+        uint64_t worldHash = 0;   // of the starting world file, 0 without one
+    };
+
+    void Begin(uint64_t seed, float dt, const Settings& settings, size_t expectedTicks = 0) {
+        this->seed = seed;
+        this->dt = dt;
+        this->settings = settings;
+        ticks.clear();
+        ticks.reserve(expectedTicks);
+    }
+
+    void Append(const InputState& in) {
+        ticks.push_back(Pack(in));
+    }
+
+    size_t TickCount() const {
+        return ticks.size();
+    }
+
+    InputState At(size_t tick) const {
+        return Unpack(ticks[tick]);
+    }
+
+    uint64_t Seed() const {
+        return seed;
+    }
+
+    float Dt() const {
+        return dt;
+    }
+
+    const Settings& GetSettings() const {
+        return settings;
+    }
+
+    // FNV-1a over a file's bytes, 0 for no path or an unreadable file
+    static uint64_t HashFile(const char* path) {
+        FILE* f = path ? fopen(path, "rb") : nullptr;
+        if (!f) return 0;
+        uint64_t h = 14695981039346656037ull;
+        unsigned char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+                h = (h ^ buf[i]) * 1099511628211ull;
+            }
+        }
+        fclose(f);
+        return h;
+    }
+
+    bool Save(const char* path) const {
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        std::vector<uint16_t> runs;
+        for (size_t i = 0; i < ticks.size();) {
+            size_t j = i + 1;
+            while (j < ticks.size() && ticks[j] == ticks[i] && j - i < 0xFFFF) ++j;
+            runs.push_back(ticks[i]);
+            runs.push_back(static_cast<uint16_t>(j - i));
+            i = j;
+        }
+        uint32_t dtBits;
+        memcpy(&dtBits, &dt, sizeof(dtBits));
+        fwrite(MAGIC, 1, 4, f);
+        WriteLE(f, VERSION, 4);
+        WriteLE(f, seed, 8);
+        WriteLE(f, dtBits, 4);
+        WriteLE(f, settings.bots, 4);
+        WriteLE(f, settings.bounces, 1);
+        WriteLE(f, settings.wavesHash, 8);
+        WriteLE(f, settings.worldHash, 8);
+        WriteLE(f, ticks.size(), 8);
+        WriteLE(f, runs.size() / 2, 4);
+        for (uint16_t w : runs) WriteLE(f, w, 2);
+        bool ok = ferror(f) == 0;
+        fclose(f);
+        return ok;
+    }
+
+    bool Load(const char* path) {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        char magic[4];
+        uint64_t version = 0, dtBits = 0, bots = 0, bounces = 0, tickCount = 0, runCount = 0;
+        bool ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, MAGIC, 4) == 0
+            && ReadLE(f, version, 4) && version == VERSION
+            && ReadLE(f, seed, 8) && ReadLE(f, dtBits, 4)
+            && ReadLE(f, bots, 4) && ReadLE(f, bounces, 1)
+            && ReadLE(f, settings.wavesHash, 8) && ReadLE(f, settings.worldHash, 8)
+            && ReadLE(f, tickCount, 8) && ReadLE(f, runCount, 4);
+        ticks.clear();
+        if (ok) {
+            settings.bots = static_cast<uint32_t>(bots);
+            settings.bounces = bounces != 0;
+            uint32_t bits32 = static_cast<uint32_t>(dtBits);
+            memcpy(&dt, &bits32, sizeof(dt));
+            ticks.reserve(static_cast<size_t>(tickCount));
+            for (uint64_t r = 0; ok && r < runCount; ++r) {
+                uint64_t bits = 0, length = 0;
+                ok = ReadLE(f, bits, 2) && ReadLE(f, length, 2) && IsValidBits(static_cast<uint16_t>(bits));
+                if (!ok) break;
+                ticks.insert(ticks.end(), static_cast<size_t>(length), static_cast<uint16_t>(bits));
+            }
+            ok = ok && ticks.size() == tickCount;
+        }
+        fclose(f);
+        return ok;
+    }
+
+    // bits 0-7: buttons, bits 8-10: shape key, bit 11: bounce toggle, bits 12-13: spawn level.
+    // Changing the layout means bumping VERSION.
+    static uint16_t Pack(const InputState& in) {
+        return static_cast<uint16_t>(
+            (in.up << 0) | (in.down << 1) | (in.left << 2) | (in.right << 3) |
+            (in.fire << 4) | (in.nextWeapon << 5) | (in.restart << 6) | (in.toggleBroadphase << 7) |
+            ((in.shapeKey & 7) << 8) | (in.toggleBounces << 11) | ((in.spawnLevel & 3) << 12));
+    }
+
+    // Spawn level in range and the spare bits clear
+    static bool IsValidBits(uint16_t bits) {
+        return ((bits >> 12) & 3) < InputState::SPAWN_LEVELS && (bits >> 14) == 0;
+    }
+
+    static InputState Unpack(uint16_t bits) {
+        InputState in;
+        in.up = bits & (1 << 0);
+        in.down = bits & (1 << 1);
+        in.left = bits & (1 << 2);
+        in.right = bits & (1 << 3);
+        in.fire = bits & (1 << 4);
+        in.nextWeapon = bits & (1 << 5);
+        in.restart = bits & (1 << 6);
+        in.toggleBroadphase = bits & (1 << 7);
+        in.shapeKey = (bits >> 8) & 7;
+        in.toggleBounces = bits & (1 << 11);
+        in.spawnLevel = (bits >> 12) & 3;
+        return in;
+    }
+
+private:
+    static void WriteLE(FILE* f, uint64_t v, int bytes) {
+        for (int i = 0; i < bytes; ++i) fputc(static_cast<int>((v >> (8 * i)) & 0xFF), f);
+    }
+
+    static bool ReadLE(FILE* f, uint64_t& v, int bytes) {
+        v = 0;
+        for (int i = 0; i < bytes; ++i) {
+            int c = fgetc(f);
+            if (c == EOF) return false;
+            v |= static_cast<uint64_t>(c) << (8 * i);
+        }
+        return true;
+    }
+
+    static constexpr char MAGIC[4] = { 'A', 'S', 'T', 'R' };
+    // 2: settings block in the header, input bits 11-13
+    static constexpr uint32_t VERSION = 2;
+
+    uint64_t              seed = 0;
+    float                 dt = 1.f / 60.f;
+    Settings              settings;
+    std::vector<uint16_t> ticks;
+};
+
+// --- SHIP HIERARCHY ---
+class Ship {
+public:
+    Ship(int screenW, int screenH) {
+        transform.position = {
+            screenW * 0.5f,
+            screenH * 0.5f
+        };
+        hp = 100;
+        maxHP = 100;
+        speed = 500.f;
+        alive = true;
+
+        // per-weapon fire rate & spacing
+        fireRateLaser = 10.f; // shots/sec
+        fireRateBullet = 30.f;
+        spacingLaser = 40.f; // px between lasers
+        spacingBullet = 20.f;
+        fireRateHoming = 12.f;
+        spacingHoming = 30.f;
+    }
+    virtual ~Ship() = default;
+    virtual void Update(float dt, const InputState& input) = 0;
+
+    void TakeDamage(int dmg) {
+        if (!alive) return;
+        hp -= dmg;
+        if (hp <= 0) alive = false;
+    }
+
+    // Plain copy of the mutable state, for world snapshots. It is written raw,
+    // so the padding is an explicit member and always zero.
+    struct State {
+        Vector2 position;
+        int     hp;
+        int     maxHP;
+        bool    alive;
+        uint8_t pad[3];
+    };
+
+    State GetState() const {
+        return { transform.position, hp, maxHP, alive, {} };
+    }
+
+    void SetState(const State& st) {
+        transform.position = st.position;
+        hp = st.hp;
+        maxHP = st.maxHP;
+        alive = st.alive;
     }
 
     bool IsAlive() const {
         return alive;
     }
 
-    Vector2 GetPosition() const {
-        return transform.position;
+    Vector2 GetPosition() const {
+        return transform.position;
+    }
+
+    virtual float GetRadius() const = 0;
+
+    int GetHP() const {
+        return hp;
+    }
+
+    int GetMaxHP() const {
+        return maxHP;
+    }
+
+    float GetFireRate(WeaponType wt) const {
+        switch (wt) {
+        case WeaponType::LASER: return fireRateLaser;
+        case WeaponType::HOMING: return fireRateHoming;
+        default: return fireRateBullet;
+        }
+    }
+
+    float GetSpacing(WeaponType wt) const {
+        switch (wt) {
+        case WeaponType::LASER: return spacingLaser;
+        case WeaponType::HOMING: return spacingHoming;
+        default: return spacingBullet;
+        }
+    }
+
+protected:
+    TransformA transform;
+    int        hp;
+    int        maxHP;
+    float      speed;
+    bool       alive;
+    float      fireRateLaser;
+    float      fireRateBullet;
+    float      spacingLaser;
+    float      spacingBullet;
+    float      fireRateHoming;
+    float      spacingHoming;
+
+    static constexpr float SPRITE_WIDTH = 399.f; // spaceship.png
+};
+
+class PlayerShip :public Ship {
+public:
+    PlayerShip(int w, int h) : Ship(w, h) {
+        scale = 0.25f;
+    }
+
+    void Update(float dt, const InputState& input) override {
+        if (alive) {
+            if (input.up) transform.position.y -= speed * dt;
+            if (input.down) transform.position.y += speed * dt;
+            if (input.left) transform.position.x -= speed * dt;
+            if (input.right) transform.position.x += speed * dt;
+        }
+        else {
+            transform.position.y += speed * dt;
+        }
+    }
+
+    // The sprite lives on the render side; the simulation only needs its size
+    float GetRadius() const override {
+        return (SPRITE_WIDTH * scale) * 0.5f;
+    }
+
+    float GetScale() const {
+        return scale;
+    }
+
+private:
+    float scale;
+};
+
+// Autopilot ship for load generation. Each tick it looks at the asteroids
+// around it, a short moment ahead, and steers away from them; with nothing
+// close it patrols around its home spot. It always fires, with its own weapon
+// and shot timer. Decisions only read the field, so many bots can decide in
+// parallel, and they are a pure function of the state, so runs with bots
+// replay exactly. A destroyed bot comes back at home after a short delay.
+class BotShip :public Ship {
+public:
+    // Bot k of count; homes are spread across the lower part of the field
+    BotShip(int screenW, int screenH, int k, int count, WeaponType weapon)
+        : Ship(screenW, screenH), screenW(screenW), screenH(screenH), weapon(weapon) {
+        speed = BOT_SPEED;
+        home = {
+            screenW * (k + 0.5f) / count,
+            screenH * (HOME_Y + HOME_ROW_STEP * (k % HOME_ROWS))
+        };
+        patrolPhase = 2.f * PI * k / count;
+        Respawn();
+    }
+
+    // Back at home with full HP, e.g. on restart
+    void Respawn() {
+        transform.position = home;
+        hp = maxHP;
+        alive = true;
+        respawnTimer = 0.f;
+        shotTimer = 0.f;
+    }
+
+    // forEachNear(pos, radius, fn) calls fn(i) for the asteroids around pos
+    template <typename Query>
+    InputState Decide(const AsteroidStore& asteroids, Query&& forEachNear) const {
+        InputState in;
+        if (!alive) return in;
+        const Vector2 pos = transform.position;
+        // Summed in fixed point: integer addition does not care in which order
+        // the query reports asteroids, so grid and brute-force runs agree
+        int64_t awayX = 0;
+        int64_t awayY = 0;
+        forEachNear(pos, SENSE_RADIUS + LOOKAHEAD * MAX_ASTEROID_SPEED, [&](size_t i) {
+            const Vector2 ahead = {
+                asteroids.posX[i] + asteroids.velX[i] * LOOKAHEAD,
+                asteroids.posY[i] + asteroids.velY[i] * LOOKAHEAD
+            };
+            const Vector2 d = Vector2Subtract(pos, ahead);
+            const float len = Vector2Length(d);
+            const float gap = len - asteroids.radius[i] - GetRadius();
+            if (gap >= SENSE_RADIUS || len <= 0.f) return;
+            // Closer threats push harder, 0 at the edge of the sense radius
+            const float w = (1.f - fmaxf(gap, 0.f) / SENSE_RADIUS) / len;
+            awayX += llroundf(d.x * w * FIXED_ONE);
+            awayY += llroundf(d.y * w * FIXED_ONE);
+        });
+
+        const Vector2 away = { awayX / FIXED_ONE, awayY / FIXED_ONE };
+        Vector2 steer = away;
+        if (Vector2Length(away) < THREAT_MIN) {
+            const Vector2 patrol = { home.x + sinf(patrolPhase) * PATROL_RANGE, home.y };
+            steer = Vector2Scale(Vector2Subtract(patrol, pos), 1.f / PATROL_RANGE);
+        }
+        in.left = steer.x < -DEADZONE;
+        in.right = steer.x > DEADZONE;
+        in.up = steer.y < -DEADZONE;
+        in.down = steer.y > DEADZONE;
+        in.fire = true;
+        return in;
+    }
+
+    void Update(float dt, const InputState& input) override {
+        if (!alive) {
+            respawnTimer += dt;
+            if (respawnTimer >= RESPAWN_DELAY) Respawn();
+            return;
+        }
+        if (input.up) transform.position.y -= speed * dt;
+        if (input.down) transform.position.y += speed * dt;
+        if (input.left) transform.position.x -= speed * dt;
+        if (input.right) transform.position.x += speed * dt;
+        transform.position.x = std::clamp(transform.position.x, 0.f, static_cast<float>(screenW));
+        transform.position.y = std::clamp(transform.position.y, 0.f, static_cast<float>(screenH));
+        patrolPhase = fmodf(patrolPhase + PATROL_RATE * dt, 2.f * PI);
+    }
+
+    float GetRadius() const override {
+        return (SPRITE_WIDTH * SCALE) * 0.5f;
+    }
+
+    WeaponType GetWeapon() const {
+        return weapon;
+    }
+
+    float& ShotTimer() {
+        return shotTimer;
+    }
+
+    // Plain copy of everything that changes while the bot plays, for world
+    // snapshots; home and weapon follow from the bot's index
+    struct BotState {
+        Ship::State ship;
+        float       patrolPhase;
+        float       respawnTimer;
+        float       shotTimer;
+    };
+
+    BotState GetBotState() const {
+        return { GetState(), patrolPhase, respawnTimer, shotTimer };
+    }
+    static_assert(sizeof(BotState) == sizeof(Ship::State) + 3 * sizeof(float), "bot records are written raw, no padding");
+
+    void SetBotState(const BotState& st) {
+        SetState(st.ship);
+        patrolPhase = st.patrolPhase;
+        respawnTimer = st.respawnTimer;
+        shotTimer = st.shotTimer;
+    }
+
+    static constexpr float SCALE = 0.12f;
+
+private:
+    int        screenW;
+    int        screenH;
+    WeaponType weapon;
+    Vector2    home{};
+    float      patrolPhase = 0.f;
+    float      respawnTimer = 0.f;
+    float      shotTimer = 0.f;
+
+    static constexpr float BOT_SPEED = 300.f;
+    static constexpr float SENSE_RADIUS = 120.f; // gap between hulls that counts as a threat
+    static constexpr float LOOKAHEAD = 0.3f;     // seconds
+    static constexpr float MAX_ASTEROID_SPEED = 200.f; // covers splits and bounces
+    static constexpr float THREAT_MIN = 0.05f;
+    static constexpr float FIXED_ONE = 65536.f;
+    static constexpr float DEADZONE = 0.1f;
+    static constexpr float PATROL_RANGE = 80.f;
+    static constexpr float PATROL_RATE = 0.8f; // radians per second
+    static constexpr float RESPAWN_DELAY = 3.f;
+    static constexpr float HOME_Y = 0.7f;      // of the field height
+    static constexpr float HOME_ROW_STEP = 0.06f;
+    static constexpr int   HOME_ROWS = 4;
+};
+
+// --- JOB SYSTEM ---
+// Small work-stealing pool for data-parallel passes. ParallelFor() cuts a range
+// into grain-sized chunks and deals them round-robin onto per-thread queues;
+// each thread pops from the back of its own queue and steals from the front of
+// the others when it runs dry. The calling thread works too and returns once
+// every chunk is done. Chunks always start at multiples of the grain, so with
+// a SIMD-friendly grain every chunk runs the same vector/scalar split as a
+// single-threaded pass. One ParallelFor at a time; no nesting.
+class JobSystem {
+public:
+    static JobSystem& Instance() {
+        static JobSystem inst;
+        return inst;
+    }
+
+    ~JobSystem() {
+        Stop();
+    }
+
+    // workers == 0 runs everything on the calling thread
+    void Start(unsigned workers) {
+        Stop();
+        queues = std::vector<Queue>(workers + 1);
+        stopping = false;
+        for (unsigned w = 0; w < workers; ++w) {
+            threads.emplace_back([this, w] { WorkerLoop(w + 1); });
+        }
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        sleepCv.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+        threads.clear();
+    }
+
+    unsigned WorkerCount() const {
+        return static_cast<unsigned>(threads.size());
+    }
+
+    // fn(begin, end) is called once per chunk, possibly on another thread
+    template <typename Fn>
+    void ParallelFor(size_t count, size_t grain, Fn&& fn) {
+        if (count == 0) return;
+        const size_t chunks = (count + grain - 1) / grain;
+        if (threads.empty() || chunks == 1) {
+            fn(size_t{ 0 }, count);
+            return;
+        }
+
+        using FnType = std::remove_reference_t<Fn>;
+        auto trampoline = [](void* ctx, size_t begin, size_t end) {
+            (*static_cast<FnType*>(ctx))(begin, end);
+        };
+
+        pending.store(chunks, std::memory_order_relaxed);
+        size_t q = 0;
+        for (size_t c = 0; c < chunks; ++c) {
+            Task task{ trampoline, &fn, c * grain, std::min(count, (c + 1) * grain) };
+            if (!queues[q].Push(task)) {
+                Execute(task); // queue full, do it here
+            }
+            else {
+                queued.fetch_add(1, std::memory_order_release);
+            }
+            q = (q + 1) % queues.size();
+        }
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex); // pairs with the workers' predicate check
+        }
+        sleepCv.notify_all();
+
+        while (pending.load(std::memory_order_acquire) > 0) {
+            Task task;
+            if (TryGet(0, task)) {
+                Execute(task);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    static constexpr size_t QUEUE_CAPACITY = 256;
+
+    struct Task {
+        void (*fn)(void*, size_t, size_t) = nullptr;
+        void*  ctx = nullptr;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    // Fixed ring, owner pops the back, thieves take the front
+    struct alignas(64) Queue {
+        std::mutex                       mutex;
+        std::array<Task, QUEUE_CAPACITY> ring;
+        size_t                           head = 0;
+        size_t                           tail = 0;
+
+        bool Push(const Task& t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail - head == QUEUE_CAPACITY) return false;
+            ring[tail++ % QUEUE_CAPACITY] = t;
+            return true;
+        }
+
+        bool PopBack(Task& t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail == head) return false;
+            t = ring[--tail % QUEUE_CAPACITY];
+            return true;
+        }
+
+        bool StealFront(Task& t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail == head) return false;
+            t = ring[head++ % QUEUE_CAPACITY];
+            return true;
+        }
+    };
+
+    JobSystem() = default;
+
+    bool TryGet(size_t self, Task& t) {
+        if (queues[self].PopBack(t)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        for (size_t k = 1; k < queues.size(); ++k) {
+            if (queues[(self + k) % queues.size()].StealFront(t)) {
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Execute(const Task& t) {
+        t.fn(t.ctx, t.begin, t.end);
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void WorkerLoop(size_t self) {
+        for (;;) {
+            Task task;
+            if (TryGet(self, task)) {
+                Execute(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCv.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+            if (stopping) return;
+        }
+    }
+
+    std::vector<Queue>       queues = std::vector<Queue>(1);
+    std::vector<std::thread> threads;
+    std::atomic<size_t>      pending{ 0 };
+    std::atomic<long long>   queued{ 0 };
+    std::mutex               sleepMutex;
+    std::condition_variable  sleepCv;
+    bool                     stopping = false;
+};
+
+// --- PROFILER ---
+// Per-phase frame timings. ScopedPhase records how long a phase took in the
+// current frame; EndFrame() commits the frame into a fixed ring of HISTORY
+// frames, from which the overlay computes min/avg/p99 and the dumps are written.
+// Phases may be recorded from the simulation and render threads; with the
+// pipelined loop a profiler frame is one simulation tick and render time is
+// attributed to the tick in flight.
+class Profiler {
+public:
+    enum Phase : uint8_t {
+        PHASE_INPUT,
+        PHASE_SHOOTING,
+        PHASE_SPAWN,
+        PHASE_HOMING,
+        PHASE_PROJECTILE_UPDATE,
+        PHASE_PROJECTILE_COLLISIONS,
+        PHASE_ASTEROID_COLLISIONS,
+        PHASE_SHIP_COLLISIONS,
+        PHASE_RENDER,
+        PHASE_COUNT
+    };
+
+    struct PhaseStats {
+        double minMs = 0.0;
+        double avgMs = 0.0;
+        double p99Ms = 0.0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    static Profiler& Instance() {
+        static Profiler inst;
+        return inst;
+    }
+
+    static const char* PhaseName(int phase) {
+        static const char* const NAMES[PHASE_COUNT] = {
+            "input", "shooting", "spawn", "homing", "projectile_update",
+            "projectile_collisions", "asteroid_collisions", "ship_collisions", "render"
+        };
+        return NAMES[phase];
+    }
+
+    // Drops the retained history, e.g. between benchmark scenarios
+    void Reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        head = 0;
+        count = 0;
+    }
+
+    void BeginFrame() {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = {};
+        current.startUs = MicrosSinceEpoch(Clock::now());
+    }
+
+    void Record(Phase phase, Clock::time_point start, Clock::time_point end) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // A phase may run several times in a frame (catch-up ticks); the trace
+        // event starts at its first run and its length is the summed time
+        if (current.phaseStartUs[phase] == 0.0) {
+            current.phaseStartUs[phase] = MicrosSinceEpoch(start);
+        }
+        current.phaseUs[phase] += static_cast<float>(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    void EndFrame(size_t asteroids, size_t projectiles) {
+        std::lock_guard<std::mutex> lock(mutex);
+        current.frameUs = static_cast<float>(MicrosSinceEpoch(Clock::now()) - current.startUs);
+        current.asteroids = static_cast<uint32_t>(asteroids);
+        current.projectiles = static_cast<uint32_t>(projectiles);
+        frames[head] = current;
+        head = (head + 1) % HISTORY;
+        count = std::min(count + 1, HISTORY);
+        totalFrames++;
+    }
+
+    // phase == PHASE_COUNT gives whole-frame statistics
+    PhaseStats Stats(int phase) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return StatsLocked(phase);
+    }
+
+    void ToggleOverlay() {
+        overlay = !overlay;
+    }
+
+    bool OverlayVisible() const {
+        return overlay;
+    }
+
+    void DrawOverlay(int x, int y) const {
+        PhaseStats st[PHASE_COUNT + 1];
+        FrameRecord last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int p = 0; p <= PHASE_COUNT; ++p) st[p] = StatsLocked(p);
+            last = frames[(head + HISTORY - 1) % HISTORY];
+        }
+        DrawText(TextFormat("asteroids %u  projectiles %u", last.asteroids, last.projectiles), x, y, 20, YELLOW);
+        y += 24;
+        DrawText("phase                    min    avg    p99 ms", x, y, 20, YELLOW);
+        for (int p = 0; p <= PHASE_COUNT; ++p) {
+            y += 22;
+            DrawText(TextFormat("%-22s %6.3f %6.3f %6.3f", p == PHASE_COUNT ? "frame" : PhaseName(p),
+                st[p].minMs, st[p].avgMs, st[p].p99Ms), x, y, 20, YELLOW);
+        }
+    }
+
+    void PrintSummary(FILE* out) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        fprintf(out, "%-22s %9s %9s %9s   (last %zu frames)\n", "phase", "min ms", "avg ms", "p99 ms", count);
+        for (int p = 0; p <= PHASE_COUNT; ++p) {
+            PhaseStats st = StatsLocked(p);
+            fprintf(out, "%-22s %9.4f %9.4f %9.4f\n", p == PHASE_COUNT ? "frame" : PhaseName(p),
+                st.minMs, st.avgMs, st.p99Ms);
+        }
+    }
+
+    // One row per retained frame, oldest first
+    bool WriteCsv(const char* path) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        fprintf(f, "frame,frame_ms");
+        for (int p = 0; p < PHASE_COUNT; ++p) fprintf(f, ",%s_ms", PhaseName(p));
+        fprintf(f, ",asteroids,projectiles\n");
+        ForEachFrame([f](uint64_t index, const FrameRecord& fr) {
+            fprintf(f, "%llu,%.4f", (unsigned long long)index, fr.frameUs / 1000.0);
+            for (int p = 0; p < PHASE_COUNT; ++p) fprintf(f, ",%.4f", fr.phaseUs[p] / 1000.0);
+            fprintf(f, ",%u,%u\n", fr.asteroids, fr.projectiles);
+        });
+        fclose(f);
+        return true;
+    }
+
+    // Chrome trace event format (chrome://tracing, Perfetto): one complete event
+    // per frame and per phase, entity counts as counter events
+    bool WriteChromeTrace(const char* path) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        FILE* f = fopen(path, "w");
+        if (!f) return false;
+        fprintf(f, "{\"traceEvents\":[\n");
+        bool first = true;
+        auto event = [&](const char* name, int tid, double ts, double dur) {
+            fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                first ? "" : ",\n", name, tid, ts, dur);
+            first = false;
+        };
+        ForEachFrame([&](uint64_t, const FrameRecord& fr) {
+            event("frame", 1, fr.startUs, fr.frameUs);
+            for (int p = 0; p < PHASE_COUNT; ++p) {
+                // render gets its own lane, it runs on the main thread when pipelined
+                if (fr.phaseUs[p] > 0.f) event(PhaseName(p), p == PHASE_RENDER ? 2 : 1, fr.phaseStartUs[p], fr.phaseUs[p]);
+            }
+            fprintf(f, ",\n{\"name\":\"entities\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"asteroids\":%u,\"projectiles\":%u}}",
+                fr.startUs, fr.asteroids, fr.projectiles);
+        });
+        fprintf(f, "\n]}\n");
+        fclose(f);
+        return true;
+    }
+
+private:
+    struct FrameRecord {
+        double   startUs = 0.0;
+        double   phaseStartUs[PHASE_COUNT] = {};
+        float    phaseUs[PHASE_COUNT] = {};
+        float    frameUs = 0.f;
+        uint32_t asteroids = 0;
+        uint32_t projectiles = 0;
+    };
+
+    PhaseStats StatsLocked(int phase) const {
+        PhaseStats st;
+        if (count == 0) return st;
+        scratch.clear();
+        double sum = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            const FrameRecord& f = frames[i];
+            float us = (phase == PHASE_COUNT) ? f.frameUs : f.phaseUs[phase];
+            scratch.push_back(us);
+            sum += us;
+        }
+        size_t p99 = std::min(count - 1, (count * 99) / 100);
+        std::nth_element(scratch.begin(), scratch.begin() + p99, scratch.end());
+        st.p99Ms = scratch[p99] / 1000.0;
+        st.minMs = *std::min_element(scratch.begin(), scratch.end()) / 1000.0;
+        st.avgMs = sum / count / 1000.0;
+        return st;
+    }
+
+    Profiler() {
+        frames.resize(HISTORY);
+        scratch.reserve(HISTORY);
+    }
+
+    double MicrosSinceEpoch(Clock::time_point t) const {
+        return std::chrono::duration<double, std::micro>(t - epoch).count();
+    }
+
+    template <typename Fn>
+    void ForEachFrame(Fn&& fn) const {
+        size_t oldest = (head + HISTORY - count) % HISTORY;
+        for (size_t i = 0; i < count; ++i) {
+            fn(totalFrames - count + i, frames[(oldest + i) % HISTORY]);
+        }
+    }
+
+    static constexpr size_t HISTORY = 600;
+
+    Clock::time_point          epoch = Clock::now();
+    std::vector<FrameRecord>   frames;
+    FrameRecord                current;
+    size_t                     head = 0;
+    size_t                     count = 0;
+    uint64_t                   totalFrames = 0;
+    mutable std::vector<float> scratch;
+    mutable std::mutex         mutex;
+    bool                       overlay = false;
+};
+
+// Times the enclosing scope as one phase of the current frame
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Profiler::Phase phase)
+        : phase(phase), start(Profiler::Clock::now()) {}
+
+    ~ScopedPhase() {
+        Profiler::Instance().Record(phase, start, Profiler::Clock::now());
+    }
+
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+private:
+    Profiler::Phase             phase;
+    Profiler::Clock::time_point start;
+};
+
+// --- RENDER SNAPSHOT ---
+// Immutable copy of everything the render stage draws, published by the
+// simulation once per tick. Drawing only ever reads a snapshot, never the
+// live simulation, so the two can run on different threads. Moving things
+// also carry where they were at the start of the tick, so frames between two
+// ticks can be drawn in between.
+struct RenderSnapshot {
+    uint64_t tick = 0;
+    double   publishedAt = 0.0; // seconds, steady clock
+
+    std::vector<float>   astX;
+    std::vector<float>   astY;
+    std::vector<float>   astPrevX;
+    std::vector<float>   astPrevY;
+    std::vector<float>   astRotation;
+    std::vector<float>   astPrevRotation;
+    std::vector<float>   astRadius;
+    std::vector<float>   astHpRatio;
+    std::vector<uint8_t> astKind;
+
+    std::vector<float>   projX;
+    std::vector<float>   projY;
+    std::vector<float>   projPrevX;
+    std::vector<float>   projPrevY;
+    std::vector<uint8_t> projType;
+
+    Vector2 shipPos{};
+    Vector2 shipPrevPos{};
+    float   shipScale = 1.f;
+    int     shipHP = 0;
+    int     shipMaxHP = 0;
+    bool    shipAlive = false;
+
+    std::vector<Vector2> botPos;
+    std::vector<Vector2> botPrevPos;
+    std::vector<uint8_t> botAlive;
+
+    WeaponType weapon = WeaponType::LASER;
+    int        points = 0;
+    bool       broadphase = true;
+    bool       bounces = false;
+
+    // Copies this snapshot into out with every position (and asteroid rotation)
+    // blended from the start of the tick toward its end: alpha 0 draws the
+    // previous tick, 1 this one. out keeps its capacity, so steady-state frames
+    // do not allocate.
+    void Interpolate(float alpha, RenderSnapshot& out) const {
+        out = *this;
+        auto lerp = [alpha](float a, float b) { return a + (b - a) * alpha; };
+        for (size_t i = 0; i < astX.size(); ++i) {
+            out.astX[i] = lerp(astPrevX[i], astX[i]);
+            out.astY[i] = lerp(astPrevY[i], astY[i]);
+            out.astRotation[i] = lerp(astPrevRotation[i], astRotation[i]);
+        }
+        for (size_t i = 0; i < projX.size(); ++i) {
+            out.projX[i] = lerp(projPrevX[i], projX[i]);
+            out.projY[i] = lerp(projPrevY[i], projY[i]);
+        }
+        out.shipPos = Vector2Lerp(shipPrevPos, shipPos, alpha);
+        for (size_t k = 0; k < botPos.size(); ++k) {
+            out.botPos[k] = Vector2Lerp(botPrevPos[k], botPos[k], alpha);
+        }
+    }
+};
+
+// Lock-free triple buffer: the producer always has a back slot to fill, the
+// consumer always holds a complete front slot, and the middle slot is swapped
+// atomically on publish/acquire. Slots keep their capacity, so steady-state
+// publishing does not allocate.
+class SnapshotBuffer {
+public:
+    RenderSnapshot& Back() {
+        return slots[back];
+    }
+
+    void Publish() {
+        back = middle.exchange(back | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Latest published snapshot; the same one again if nothing new arrived
+    const RenderSnapshot& Acquire() {
+        if (middle.load(std::memory_order_relaxed) & DIRTY) {
+            front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        }
+        return slots[front];
+    }
+
+private:
+    static constexpr int DIRTY = 4;
+    static constexpr int INDEX_MASK = 3;
+
+    RenderSnapshot   slots[3];
+    int              back = 0;
+    std::atomic<int> middle{ 1 };
+    int              front = 2;
+};
+
+// --- CULLING ---
+// Render-side visibility and level-of-detail pass over a snapshot. Decides what
+// DrawSnapshot queues; the simulation is unaffected.
+//  - asteroids and projectiles entirely outside the screen are skipped
+//  - HP bars are only drawn for damaged asteroids
+//  - with very many asteroids on screen the small ones collapse into points
+//  - with very many projectiles, ones landing on an already drawn spot of the
+//    same type are merged away
+class RenderCuller {
+public:
+    struct Stats {
+        size_t asteroidsDrawn = 0;
+        size_t asteroidsCulled = 0;
+        size_t asteroidsAsPoints = 0;
+        size_t barsSkipped = 0;
+        size_t projectilesDrawn = 0;
+        size_t projectilesCulled = 0;
+        size_t projectilesMerged = 0;
+    };
+
+    void Build(const RenderSnapshot& snap, int screenW, int screenH) {
+        stats = {};
+        const float w = static_cast<float>(screenW);
+        const float h = static_cast<float>(screenH);
+
+        asteroids.clear();
+        bars.clear();
+        for (size_t i = 0; i < snap.astX.size(); ++i) {
+            const float r = snap.astRadius[i];
+            // the HP bar sits BAR_OFFSET above the outline
+            if (snap.astX[i] + r < 0.f || snap.astX[i] - r > w || snap.astY[i] + r < 0.f || snap.astY[i] - r - BAR_OFFSET > h) {
+                stats.asteroidsCulled++;
+                continue;
+            }
+            asteroids.push_back(static_cast<uint32_t>(i));
+            if (snap.astHpRatio[i] < 1.f) {
+                bars.push_back(static_cast<uint32_t>(i));
+            }
+            else {
+                stats.barsSkipped++;
+            }
+        }
+        stats.asteroidsDrawn = asteroids.size();
+
+        pointRadius = 0.f;
+        if (asteroids.size() > C_POINTS_HUGE) pointRadius = C_POINT_RADIUS_HUGE;
+        else if (asteroids.size() > C_POINTS_MANY) pointRadius = C_POINT_RADIUS_MANY;
+        if (pointRadius > 0.f) {
+            for (uint32_t i : asteroids) stats.asteroidsAsPoints += snap.astRadius[i] <= pointRadius;
+        }
+
+        projectiles.clear();
+        const size_t np = snap.projX.size();
+        const bool merge = np > C_MERGE_PROJECTILES;
+        if (merge) {
+            cellsX = screenW / MERGE_CELL + 1;
+            cellsY = screenH / MERGE_CELL + 1;
+            occupied.assign(static_cast<size_t>(WeaponType::COUNT) * cellsX * cellsY, 0);
+        }
+        for (size_t i = 0; i < np; ++i) {
+            const float x = snap.projX[i];
+            const float y = snap.projY[i];
+            if (x < -PROJECTILE_MARGIN || x > w + PROJECTILE_MARGIN || y < -PROJECTILE_MARGIN || y > h + PROJECTILE_MARGIN) {
+                stats.projectilesCulled++;
+                continue;
+            }
+            if (merge) {
+                int cx = std::clamp(static_cast<int>(x) / MERGE_CELL, 0, cellsX - 1);
+                int cy = std::clamp(static_cast<int>(y) / MERGE_CELL, 0, cellsY - 1);
+                uint8_t& cell = occupied[(static_cast<size_t>(snap.projType[i]) * cellsY + cy) * cellsX + cx];
+                if (cell) {
+                    stats.projectilesMerged++;
+                    continue;
+                }
+                cell = 1;
+            }
+            projectiles.push_back(static_cast<uint32_t>(i));
+        }
+        stats.projectilesDrawn = projectiles.size();
+    }
+
+    const std::vector<uint32_t>& Asteroids() const {
+        return asteroids;
+    }
+
+    const std::vector<uint32_t>& Bars() const {
+        return bars;
+    }
+
+    const std::vector<uint32_t>& Projectiles() const {
+        return projectiles;
+    }
+
+    // Asteroids up to this radius are drawn as points, 0 when none are
+    float PointRadius() const {
+        return pointRadius;
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+    static constexpr float BAR_OFFSET = 10.f;
+
+private:
+    static constexpr float PROJECTILE_MARGIN = 30.f; // longest projectile sprite (laser)
+    static constexpr int MERGE_CELL = 2;             // px
+
+    static constexpr size_t C_POINTS_MANY = 2'000;
+    static constexpr size_t C_POINTS_HUGE = 8'000;
+    static constexpr float C_POINT_RADIUS_MANY = 16.f; // smallest size only
+    static constexpr float C_POINT_RADIUS_HUGE = 32.f;
+    static constexpr size_t C_MERGE_PROJECTILES = 4'096;
+
+    std::vector<uint32_t> asteroids;
+    std::vector<uint32_t> bars;
+    std::vector<uint32_t> projectiles;
+    std::vector<uint8_t>  occupied;
+    int                   cellsX = 0;
+    int                   cellsY = 0;
+    float                 pointRadius = 0.f;
+    Stats                 stats;
+};
+
+// --- PARTICLES ---
+// Something the render side may want to show: a projectile hitting an asteroid
+// or an asteroid being destroyed. The simulation records them in the serial
+// part of its collision passes; they do not affect the simulation itself.
+struct ImpactEvent {
+    float   x;
+    float   y;
+    float   dirX; // hits: surface normal at the impact point
+    float   dirY;
+    float   velX; // the asteroid's velocity
+    float   velY;
+    uint8_t kind;
+    uint8_t size;
+    bool    destroyed;
+};
+
+// Hands impact events from the simulation thread to the render thread. Each
+// tick's events are appended until the render side takes them, so nothing is
+// lost while rendering runs slower than the simulation; beyond the cap they
+// are dropped. Both buffers are reserved up front and swapped, never regrown.
+class ImpactLatch {
+public:
+    explicit ImpactLatch(size_t capacity) {
+        pending.reserve(capacity);
+        taken.reserve(capacity);
+    }
+
+    void Push(const std::vector<ImpactEvent>& events) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const size_t n = std::min(events.size(), pending.capacity() - pending.size());
+        pending.insert(pending.end(), events.begin(), events.begin() + n);
+    }
+
+    // Everything pushed since the last call; valid until the next one
+    const std::vector<ImpactEvent>& Take() {
+        std::lock_guard<std::mutex> lock(mutex);
+        taken.clear();
+        taken.swap(pending);
+        return taken;
+    }
+
+private:
+    std::mutex               mutex;
+    std::vector<ImpactEvent> pending;
+    std::vector<ImpactEvent> taken;
+};
+
+// Purely visual sparks and debris with a hard cap. Particles live in SoA
+// columns reserved once at Init(); the update is two SIMD passes (move, age)
+// writing one shared kill mask, followed by an order-keeping compaction, and
+// everything alive goes out as tinted quads of one atlas sprite in a single
+// textured run. Emits past the cap are dropped and counted.
+class ParticleSystem {
+public:
+    void Init(size_t maxParticles) {
+        capacity = maxParticles;
+        ForEachArray([maxParticles](auto& arr) {
+            arr.clear();
+            arr.reserve(maxParticles);
+        });
+        mask.reserve(maxParticles);
+    }
+
+    size_t Size() const {
+        return x.size();
+    }
+
+    uint64_t Dropped() const {
+        return dropped;
+    }
+
+    // Sparks thrown off the surface for a hit, a burst of debris in the
+    // asteroid's colour for a destruction, more for bigger asteroids. density
+    // scales every count, 0 emits nothing.
+    void Emit(const ImpactEvent* events, size_t n, float density = 1.f) {
+        const int sparks = static_cast<int>(SPARKS_PER_HIT * density);
+        for (size_t e = 0; e < n; ++e) {
+            const ImpactEvent& ev = events[e];
+            if (ev.destroyed) {
+                const int count = static_cast<int>((DEBRIS_BASE + DEBRIS_PER_SIZE * ev.size) * density);
+                const Color color = ASTEROID_KINDS[ev.kind].color;
+                for (int k = 0; k < count; ++k) {
+                    const float a = rng.Float(0.f, 2.f * PI);
+                    const float speed = rng.Float(DEBRIS_SPEED_MIN, DEBRIS_SPEED_MAX);
+                    Add(ev.x, ev.y, ev.velX + cosf(a) * speed, ev.velY + sinf(a) * speed,
+                        rng.Float(DEBRIS_LIFE_MIN, DEBRIS_LIFE_MAX), DEBRIS_SIZE, color);
+                }
+            }
+            else {
+                const float normal = atan2f(ev.dirY, ev.dirX);
+                for (int k = 0; k < sparks; ++k) {
+                    const float a = normal + rng.Float(-SPARK_SPREAD, SPARK_SPREAD);
+                    const float speed = rng.Float(SPARK_SPEED_MIN, SPARK_SPEED_MAX);
+                    Add(ev.x, ev.y, cosf(a) * speed, sinf(a) * speed,
+                        rng.Float(SPARK_LIFE_MIN, SPARK_LIFE_MAX), SPARK_SIZE, SPARK_COLOR);
+                }
+            }
+        }
+    }
+
+    // Moves and ages everything, then drops what expired or left bounds
+    void Update(float dt, Kinematics::Bounds bounds) {
+        const size_t n = Size();
+        mask.resize(n);
+        Kinematics::Integrate(x.data(), y.data(), velX.data(), velY.data(), nullptr, n, dt, bounds, mask.data());
+        Kinematics::Expire(life.data(), n, dt, mask.data());
+        // Everything before the first expired particle stays where it is
+        const size_t first = static_cast<size_t>(std::find(mask.begin(), mask.end(), 1) - mask.begin());
+        if (first == n) return;
+        ForEachArray([this, n, first](auto& arr) {
+            size_t out = first;
+            for (size_t i = first + 1; i < n; ++i) {
+                if (!mask[i]) arr[out++] = arr[i];
+            }
+            arr.resize(out);
+        });
+    }
+
+    // One quad per particle, fading out over its life
+    void Queue(Renderer& renderer, const Rectangle& src) const {
+        const size_t n = Size();
+        for (size_t i = 0; i < n; ++i) {
+            const float s = size[i];
+            Color c = color[i];
+            c.a = static_cast<uint8_t>(255.f * std::min(1.f, life[i] * invLife[i]));
+            renderer.QueueSprite(src, { x[i] - s * 0.5f, y[i] - s * 0.5f, s, s }, c, Renderer::LAYER_PARTICLES);
+        }
+    }
+
+private:
+    void Add(float px, float py, float vx, float vy, float lifetime, float sz, Color c) {
+        if (Size() == capacity) {
+            dropped++;
+            return;
+        }
+        x.push_back(px);
+        y.push_back(py);
+        velX.push_back(vx);
+        velY.push_back(vy);
+        life.push_back(lifetime);
+        invLife.push_back(1.f / lifetime);
+        size.push_back(sz);
+        color.push_back(c);
+    }
+
+    template <typename Fn>
+    void ForEachArray(Fn&& fn) {
+        fn(x); fn(y); fn(velX); fn(velY);
+        fn(life); fn(invLife); fn(size); fn(color);
+    }
+
+    static constexpr int   SPARKS_PER_HIT = 6;
+    static constexpr float SPARK_SPREAD = 60.f * DEG2RAD;
+    static constexpr float SPARK_SPEED_MIN = 80.f;
+    static constexpr float SPARK_SPEED_MAX = 240.f;
+    static constexpr float SPARK_LIFE_MIN = 0.15f;
+    static constexpr float SPARK_LIFE_MAX = 0.35f;
+    static constexpr float SPARK_SIZE = 2.f;
+    static constexpr Color SPARK_COLOR = { 255, 220, 120, 255 };
+
+    static constexpr int   DEBRIS_BASE = 10;
+    static constexpr int   DEBRIS_PER_SIZE = 10; // times Renderable::Size
+    static constexpr float DEBRIS_SPEED_MIN = 30.f;
+    static constexpr float DEBRIS_SPEED_MAX = 160.f;
+    static constexpr float DEBRIS_LIFE_MIN = 0.4f;
+    static constexpr float DEBRIS_LIFE_MAX = 0.9f;
+    static constexpr float DEBRIS_SIZE = 3.f;
+
+    std::vector<float>   x;
+    std::vector<float>   y;
+    std::vector<float>   velX;
+    std::vector<float>   velY;
+    std::vector<float>   life;    // seconds left
+    std::vector<float>   invLife; // 1 / starting life, for the fade
+    std::vector<float>   size;
+    std::vector<Color>   color;
+    std::vector<uint8_t> mask;
+
+    size_t   capacity = 0;
+    uint64_t dropped = 0;
+    Rng      rng{ 0, RNG_STREAM_PARTICLES };
+};
+
+// --- WORLD FILE ---
+// Flat binary world snapshot. A fixed header holds the scalar state and a
+// column table; every SoA array follows as raw native-endian POD, 64-byte
+// aligned, so a mapped file is restored with one memcpy per column and no
+// per-entity parsing. The last column holds one BotShip::BotState per bot. Any
+// layout change bumps VERSION.
+//
+//   WorldHeader | WorldColumn[columnCount] | pad | column 0 | pad | column 1 ...
+struct WorldColumn {
+    uint64_t offset;   // from the start of the file
+    uint64_t count;    // elements
+    uint32_t elemSize; // bytes per element, checked on load
+    uint32_t reserved;
+};
+
+struct WorldHeader {
+    char     magic[4];
+    uint32_t version;
+    uint32_t headerBytes;
+    uint32_t columnCount;
+    uint64_t tick;
+    uint64_t asteroidCapacity;
+    uint64_t projectileCapacity;
+    Rng::State  spawnRng;
+    Rng::State  timerRng;
+    Rng::State  fragmentRng;
+    Ship::State ship;
+    float    spawnTimer;
+    float    spawnInterval;
+    float    shotTimer;
+    int32_t  points;
+    uint8_t  weapon;
+    uint8_t  shape;
+    uint8_t  broadphase;
+    uint8_t  bounces;
+
+    static constexpr char MAGIC[4] = { 'A', 'S', 'T', 'W' };
+    static constexpr uint32_t VERSION = 4;
+    static constexpr size_t ALIGN = 64;
+};
+static_assert(std::is_trivially_copyable<WorldHeader>::value, "world header is copied raw");
+static_assert(sizeof(Ship::State) == sizeof(Vector2) + 2 * sizeof(int) + sizeof(bool) + 3, "ship state is written raw, no padding");
+
+// Read-only view of a whole file. Snapshots are mapped rather than read, so a
+// load copies straight from the page cache into the stores.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        Close();
+    }
+
+    bool Open(const char* path) {
+        Close();
+#if defined(_WIN32)
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            Close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mapping ? static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        size = static_cast<size_t>(fileSize.QuadPart);
+#else
+        fd = open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            Close();
+            return false;
+        }
+        size = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = (p == MAP_FAILED) ? nullptr : static_cast<const uint8_t*>(p);
+#endif
+        if (!data) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+#if defined(_WIN32)
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+        if (fd >= 0) close(fd);
+        fd = -1;
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const uint8_t* Data() const {
+        return data;
+    }
+
+    size_t Size() const {
+        return size;
+    }
+
+private:
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    const uint8_t* data = nullptr;
+    size_t         size = 0;
+};
+
+// --- WAVES ---
+// Timed spawn waves read from a text file, one wave per line, in time order:
+//
+//   # time  count  shape     [interval  repeats]
+//   0.0     20     random
+//   5.0     500    square
+//   10.0    200    heavy     0.5        10      # 10 bursts of 200, 0.5 s apart
+//
+// time and interval are seconds; shape is triangle, square, pentagon, heavy or
+// random. The file is streamed: only the next line is parsed ahead of time, so
+// arbitrarily long load curves cost a fixed amount of memory.
+class WaveScheduler {
+public:
+    WaveScheduler() = default;
+    WaveScheduler(const WaveScheduler&) = delete;
+    WaveScheduler& operator=(const WaveScheduler&) = delete;
+
+    ~WaveScheduler() {
+        Close();
+    }
+
+    bool Open(const char* path) {
+        Close();
+        file = fopen(path, "r");
+        if (!file) return false;
+        active.reserve(MAX_ACTIVE);
+        Rewind();
+        return true;
+    }
+
+    void Close() {
+        if (file) fclose(file);
+        file = nullptr;
+        active.clear();
+        hasPending = false;
+    }
+
+    bool IsOpen() const {
+        return file != nullptr;
+    }
+
+    void Rewind() {
+        rewind(file);
+        line = 0;
+        lastTime = 0.f;
+        active.clear();
+        ReadNext();
+    }
+
+    // Fires everything due by time (seconds since the file started) through
+    // spawn(count, shape), one call per burst
+    template <typename SpawnFn>
+    void Advance(float time, SpawnFn&& spawn) {
+        while (hasPending && pending.nextTime <= time) {
+            if (active.size() < MAX_ACTIVE) {
+                active.push_back(pending);
+            }
+            else {
+                TraceLog(LOG_WARNING, "Wave file line %d: more than %zu overlapping waves, dropped", line, MAX_ACTIVE);
+            }
+            ReadNext();
+        }
+        for (size_t i = 0; i < active.size();) {
+            Wave& w = active[i];
+            while (w.remaining > 0 && w.nextTime <= time) {
+                spawn(w.count, w.shape);
+                w.nextTime += w.interval;
+                w.remaining--;
+            }
+            if (w.remaining == 0) {
+                active[i] = active.back();
+                active.pop_back();
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
+private:
+    struct Wave {
+        float         nextTime;
+        float         interval;
+        int           remaining;
+        size_t        count;
+        AsteroidShape shape;
+    };
+
+    // Parses lines until the next valid wave or end of file
+    void ReadNext() {
+        hasPending = false;
+        char buf[256];
+        while (fgets(buf, sizeof(buf), file)) {
+            line++;
+            if (char* hash = strchr(buf, '#')) *hash = '\0';
+            float time = 0.f, interval = 0.f;
+            long count = 0;
+            int repeats = 1;
+            char shapeName[32];
+            int fields = sscanf(buf, "%f %ld %31s %f %d", &time, &count, shapeName, &interval, &repeats);
+            if (fields == EOF) continue; // blank or comment only
+            AsteroidShape shape;
+            if (fields < 3 || count <= 0 || repeats <= 0 || interval < 0.f || !ParseShape(shapeName, shape)) {
+                TraceLog(LOG_WARNING, "Wave file line %d: expected 'time count shape [interval repeats]'", line);
+                continue;
+            }
+            if (time < lastTime) {
+                TraceLog(LOG_WARNING, "Wave file line %d: time goes backwards, firing at %.3f", line, lastTime);
+                time = lastTime;
+            }
+            lastTime = time;
+            pending = { time, interval, fields >= 5 ? repeats : 1, static_cast<size_t>(count), shape };
+            hasPending = true;
+            return;
+        }
+    }
+
+    static bool ParseShape(const char* name, AsteroidShape& shape) {
+        static constexpr struct { const char* name; AsteroidShape shape; } NAMES[] = {
+            { "triangle", AsteroidShape::TRIANGLE }, { "square", AsteroidShape::SQUARE },
+            { "pentagon", AsteroidShape::PENTAGON }, { "heavy", AsteroidShape::REDHEAVY },
+            { "random", AsteroidShape::RANDOM },
+        };
+        for (const auto& n : NAMES) {
+            if (strcmp(name, n.name) == 0) {
+                shape = n.shape;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static constexpr size_t MAX_ACTIVE = 64;
+
+    FILE*             file = nullptr;
+    int               line = 0;
+    float             lastTime = 0.f;
+    Wave              pending{};
+    bool              hasPending = false;
+    std::vector<Wave> active;
+};
+
+// --- SIMULATION ---
+// Limits and rates the game runs with. The defaults are the game's; benchmark
+// scenarios push them to stress the entity pipeline.
+struct SimulationConfig {
+    size_t     maxAsteroidsOnField = 150;
+    float      spawnMin = 0.5f;
+    float      spawnMax = 3.0f;
+    int        spawnBurst = 1; // asteroids per spawn event
+    size_t     asteroidCapacity = 1000;
+    size_t     projectileCapacity = 10'000;
+    float      fireRateScale = 1.f; // more shots per second, same projectile speed
+    bool       invulnerable = false; // ship collisions are still tested but do no damage
+    bool       asteroidBounces = false; // asteroids collide elastically with each other
+    bool       splitAsteroids = true; // destroyed LARGE/MEDIUM asteroids break into two smaller ones
+    int        bots = 0; // autopilot ships besides the player
+    WeaponType startWeapon = WeaponType::LASER;
+};
+
+// Everything that advances the game state. No window, timing or keyboard access:
+// the caller supplies dt and input, so the same code runs windowed and headless.
+class Simulation {
+public:
+    // The seed fixes every random draw, so (seed, dt, inputs) replays a run exactly
+    Simulation(int screenW, int screenH, uint64_t seed, const SimulationConfig& config = {})
+        : screenW(screenW), screenH(screenH), config(config),
+          spawnRng(seed, RNG_STREAM_SPAWN), timerRng(seed, RNG_STREAM_SPAWN_TIMER),
+          fragmentRng(seed, RNG_STREAM_FRAGMENTS),
+          currentWeapon(config.startWeapon), asteroidBounces(config.asteroidBounces)
+    {
+        asteroids.Init(config.asteroidCapacity);
+        projectiles.Init(config.projectileCapacity);
+        fragments.Init(config.asteroidCapacity);
+        asteroidBvh.Reserve(config.asteroidCapacity);
+        loadSeen.reserve(config.asteroidCapacity);
+        homingRows.reserve(config.projectileCapacity);
+        homingX.reserve(config.projectileCapacity);
+        homingY.reserve(config.projectileCapacity);
+        homingLimitSq.reserve(config.projectileCapacity);
+        homingNearest.reserve(config.projectileCapacity);
+        impacts.reserve(C_MAX_IMPACTS);
+        bots.reserve(static_cast<size_t>(std::max(config.bots, 0)));
+        botStart.reserve(bots.capacity());
+        for (int k = 0; k < config.bots; ++k) {
+            const auto weapon = static_cast<WeaponType>(k % static_cast<int>(WeaponType::COUNT));
+            bots.push_back(std::make_unique<BotShip>(screenW, screenH, k, config.bots, weapon));
+        }
+        Reset();
+        SaveWorld(restartImage);
+    }
+
+    void Reset() {
+        player = std::make_unique<PlayerShip>(screenW, screenH);
+        asteroids.Clear();
+        projectiles.Clear();
+        spawnTimer = 0.f;
+        spawnInterval = timerRng.Float(config.spawnMin, config.spawnMax);
+        points = 0; // Reset points on restart
+        for (auto& bot : bots) {
+            bot->Respawn();
+        }
+    }
+
+    void Step(float dt, const InputState& input) {
+        tick++;
+        spawnTimer += dt;
+        lastDt = dt;
+        impacts.clear();
+        playerStart = player->GetPosition();
+
+        // Player movement and input handling
+        {
+            ScopedPhase timer(Profiler::PHASE_INPUT);
+
+            // Update player
+            player->Update(dt, input);
+
+            // Restart logic
+            if (!player->IsAlive() && input.restart) {
+                Restart();
+                playerStart = player->GetPosition();
+            }
+            // Asteroid shape switch
+            switch (input.shapeKey) {
+            case 1: currentShape = AsteroidShape::TRIANGLE; break;
+            case 2: currentShape = AsteroidShape::SQUARE; break;
+            case 3: currentShape = AsteroidShape::PENTAGON; break;
+            case 4: currentShape = AsteroidShape::RANDOM; break;
+            case 5: currentShape = AsteroidShape::REDHEAVY; break;
+            default: break;
+            }
+
+            // Weapon switch
+            if (input.nextWeapon) {
+                currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
+            }
+
+            // Broadphase switch (A/B against brute force)
+            if (input.toggleBroadphase) {
+                useBroadphase = !useBroadphase;
+            }
+            if (input.toggleBounces) {
+                asteroidBounces = !asteroidBounces;
+            }
+            spawnCap = static_cast<size_t>(config.maxAsteroidsOnField * C_SPAWN_LEVEL_SCALE[input.spawnLevel]);
+        }
+
+        // Spawn asteroids
+        {
+            ScopedPhase timer(Profiler::PHASE_SPAWN);
+            if (waves.IsOpen()) {
+                // A wave file scripts the load exactly: only the pool's capacity
+                // limits a burst, not the timer's field cap or spawn level.
+                waveClock += dt;
+                waves.Advance(waveClock, [&](size_t count, AsteroidShape shape) {
+                    asteroids.SpawnBatch(count, screenW, screenH, shape, spawnRng);
+                });
+            }
+            else if (spawnTimer >= spawnInterval && asteroids.Size() < spawnCap) {
+                SpawnUpToLimit(static_cast<size_t>(config.spawnBurst), currentShape);
+                spawnTimer = 0.f;
+                spawnInterval = timerRng.Float(config.spawnMin, config.spawnMax);
+            }
+        }
+
+        // Shooting: the player, then every bot in order. Bots steer on the field
+        // as it stands now, which is also what the projectile pass sees, so the
+        // grid built for them is reused there.
+        bool gridBuilt = false;
+        {
+            ScopedPhase timer(Profiler::PHASE_SHOOTING);
+            Fire(*player, currentWeapon, player->IsAlive() && input.fire, dt, shotTimer);
+            if (!bots.empty()) {
+                if (useBroadphase) {
+                    grid.Build(asteroids, screenW, screenH);
+                    gridBuilt = true;
+                }
+                UpdateBots(dt);
+            }
+        }
+
+        // Homing projectiles pick their asteroid on the field as it stands after
+        // spawning and turn toward it before they move
+        {
+            ScopedPhase timer(Profiler::PHASE_HOMING);
+            SteerHoming(dt);
+        }
+
+        JobSystem& jobs = JobSystem::Instance();
+        const Kinematics::Bounds field = { 0.f, 0.f, static_cast<float>(screenW), static_cast<float>(screenH) };
+
+        // Update projectiles - move them forward, drop the ones that left the field.
+        // The start position is kept for the swept collision test.
+        {
+            ScopedPhase timer(Profiler::PHASE_PROJECTILE_UPDATE);
+            const size_t n = projectiles.Size();
+            boundsMask.resize(n);
+            jobs.ParallelFor(n, C_GRAIN_INTEGRATE, [this, dt, &field](size_t b, size_t e) {
+                std::copy(projectiles.posX.begin() + b, projectiles.posX.begin() + e, projectiles.prevX.begin() + b);
+                std::copy(projectiles.posY.begin() + b, projectiles.posY.begin() + e, projectiles.prevY.begin() + b);
+                Kinematics::Integrate(projectiles.posX.data() + b, projectiles.posY.data() + b,
+                    projectiles.velX.data() + b, projectiles.velY.data() + b, nullptr, e - b, dt,
+                    field, boundsMask.data() + b);
+            });
+            projectiles.RemoveFlagged(boundsMask);
+        }
+
+        // Projectile-Asteroid collisions - swept over the projectile's path this tick,
+        // grid broadphase, or O(n^2) when toggled off.
+        // Destroyed asteroids are only flagged here and compacted after the pass;
+        // their fragments are queued and inserted after the compaction.
+        // Candidates are found in parallel against the untouched field; damage is
+        // then applied serially in projectile order, re-querying the rare projectile
+        // whose candidate was already destroyed earlier in the pass. That is exactly
+        // what the plain serial loop would do, so thread count never changes results.
+        {
+            ScopedPhase timer(Profiler::PHASE_PROJECTILE_COLLISIONS);
+            const size_t np = projectiles.Size();
+            asteroidDead.assign(asteroids.Size(), 0);
+            projectileHit.assign(np, 0);
+            projectileTarget.resize(np);
+            if (useBroadphase && !gridBuilt) {
+                grid.Build(asteroids, screenW, screenH);
+            }
+
+            jobs.ParallelFor(np, C_GRAIN_COLLIDE, [this](size_t b, size_t e) {
+                for (size_t p = b; p < e; ++p) {
+                    projectileTarget[p] = FindEarliestHit(p);
+                }
+            });
+
+            for (size_t p = 0; p < np; ++p) {
+                int idx = projectileTarget[p];
+                if (idx >= 0 && asteroidDead[idx]) {
+                    idx = FindEarliestHit(p);
+                }
+                if (idx < 0) {
+                    continue;
+                }
+                projectileHit[p] = 1;
+                asteroids.TakeDamage(idx, projectiles.damage[p]);
+                RecordImpact(idx, projectiles.GetPrevPosition(p), asteroids.IsDestroyed(idx));
+                if (asteroids.IsDestroyed(idx)) {
+                    asteroidDead[idx] = 1;
+                    points++; // Add point when asteroid is destroyed
+                    if (config.splitAsteroids) {
+                        fragments.Split(asteroids, idx, fragmentRng);
+                    }
+                }
+            }
+
+            projectiles.RemoveFlagged(projectileHit);
+            asteroids.RemoveFlagged(asteroidDead);
+            asteroids.SpawnFragments(fragments.Data(), fragments.Size());
+            fragments.Clear();
+        }
+
+        // Asteroid-Asteroid bounces. Pairs are resolved serially in sweep order,
+        // which only depends on the field. The sweep is only kept while bounces or
+        // bots need it: for the player alone, the linear test folded into
+        // integration is cheaper than keeping the list sorted.
+        const bool useSweep = asteroidBounces || (useBroadphase && !bots.empty());
+        {
+            ScopedPhase timer(Profiler::PHASE_ASTEROID_COLLISIONS);
+            if (useSweep) {
+                sweep.Update(asteroids);
+            }
+            if (asteroidBounces) {
+                sweep.ForEachOverlap([this](uint32_t a, uint32_t b) {
+                    BounceAsteroids(asteroids, a, b);
+                });
+            }
+            else if (!useSweep && !sweep.Empty()) {
+                sweep.Clear(); // a stale order would cost a long insertion sort later
+            }
+        }
+
+        // Asteroid-Ship collisions against the pre-move positions, then move the
+        // whole field in one batch and drop what collided or left the field.
+        // With the sweep up to date a ship only tests what lies under its x
+        // extent, otherwise every asteroid. Integration runs in parallel; damage is
+        // applied in index order so a ship dies on the same asteroid as in a
+        // serial pass. An asteroid touching several ships hits the first of them,
+        // player before bots.
+        {
+            ScopedPhase timer(Profiler::PHASE_SHIP_COLLISIONS);
+            const size_t n = asteroids.Size();
+            asteroidDead.assign(n, 0);
+            boundsMask.resize(n);
+            const Vector2 shipPos = player->GetPosition();
+            const float shipRadius = player->GetRadius();
+            const bool shipAlive = player->IsAlive();
+            auto testShip = [&](size_t i) {
+                float dist = Vector2Distance(shipPos, asteroids.GetPosition(i));
+                asteroidDead[i] = dist < shipRadius + asteroids.radius[i];
+            };
+            const bool shipSweep = shipAlive && useBroadphase && useSweep;
+            if (!bots.empty()) {
+                TestShips(useBroadphase && useSweep);
+            }
+            else if (shipSweep) {
+                sweep.QueryX(shipPos.x - shipRadius, shipPos.x + shipRadius, testShip);
+            }
+
+            jobs.ParallelFor(n, C_GRAIN_INTEGRATE, [&, dt](size_t b, size_t e) {
+                if (shipAlive && !shipSweep && bots.empty()) {
+                    for (size_t i = b; i < e; ++i) {
+                        testShip(i);
+                    }
+                }
+                Kinematics::Integrate(asteroids.posX.data() + b, asteroids.posY.data() + b,
+                    asteroids.velX.data() + b, asteroids.velY.data() + b, asteroids.radius.data() + b, e - b, dt,
+                    field, boundsMask.data() + b);
+                Kinematics::Advance(asteroids.rotation.data() + b, asteroids.rotationSpeed.data() + b, e - b, dt);
+            });
+
+            for (size_t i = 0; i < n; ++i) {
+                if (asteroidDead[i]) {
+                    Ship& ship = bots.empty() ? static_cast<Ship&>(*player) : ShipAt(hitShip[i]);
+                    if (ship.IsAlive()) {
+                        if (!config.invulnerable) {
+                            ship.TakeDamage(asteroids.damage[i]); // Mark asteroid for removal due to collision
+                        }
+                        RecordImpact(i, ship.GetPosition(), true);
+                    }
+                    else {
+                        asteroidDead[i] = 0; // ship already died earlier in this pass
+                    }
+                }
+                asteroidDead[i] |= boundsMask[i];
+            }
+            asteroids.RemoveFlagged(asteroidDead);
+        }
+    }
+
+    // What a world restore brings back. RESTART keeps the session (random
+    // streams, tick, weapon/shape/collision choices, shot timer) like Reset().
+    enum class Restore { FULL, RESTART };
+
+    // Serialises the whole world into out in the WORLD FILE layout. out keeps
+    // its capacity, so repeated saves into the same buffer do not allocate.
+    void SaveWorld(std::vector<uint8_t>& out) const {
+        WorldHeader hdr;
+        WorldColumn columns[C_WORLD_COLUMNS];
+        out.assign(DescribeWorld(hdr, columns), 0);
+        memcpy(out.data(), &hdr, sizeof(hdr));
+        memcpy(out.data() + sizeof(hdr), columns, sizeof(columns));
+        uint32_t n = 0;
+        auto copy = [&](const auto& arr) {
+            if (n == C_WORLD_STORE_COLUMNS) return;
+            if (!arr.empty()) memcpy(out.data() + columns[n].offset, arr.data(), arr.size() * sizeof(arr[0]));
+            n++;
+        };
+        asteroids.ForEachColumn(copy);
+        projectiles.ForEachColumn(copy);
+        for (size_t k = 0; k < bots.size(); ++k) {
+            const BotShip::BotState st = bots[k]->GetBotState();
+            memcpy(out.data() + columns[C_WORLD_BOT_COLUMN].offset + k * sizeof(st), &st, sizeof(st));
+        }
+    }
+
+    // Restores a world written by SaveWorld, e.g. straight from a mapped file.
+    // The whole image is validated before any state changes: header enums and
+    // flags, every column's placement and element size, and the columns of
+    // each store against each other. A rejected image leaves the world as it was.
+    bool LoadWorld(const uint8_t* data, size_t size, Restore mode = Restore::FULL) {
+        WorldHeader hdr;
+        WorldColumn columns[C_WORLD_COLUMNS];
+        if (size < sizeof(hdr) + sizeof(columns)) return false;
+        memcpy(&hdr, data, sizeof(hdr));
+        memcpy(columns, data + sizeof(hdr), sizeof(columns));
+        if (memcmp(hdr.magic, WorldHeader::MAGIC, sizeof(hdr.magic)) != 0 || hdr.version != WorldHeader::VERSION ||
+            hdr.headerBytes != sizeof(WorldHeader) || hdr.columnCount != C_WORLD_COLUMNS) {
+            return false;
+        }
+        uint32_t n = 0;
+        bool ok = IsValidWorldHeader(hdr, data);
+        ColumnView views[C_WORLD_COLUMNS];
+        auto fits = [&](const WorldColumn& c, size_t elemSize) {
+            return c.elemSize == elemSize && c.offset % WorldHeader::ALIGN == 0 &&
+                c.offset <= size && c.count <= (size - c.offset) / c.elemSize;
+        };
+        auto check = [&](const auto& arr) {
+            if (n == C_WORLD_STORE_COLUMNS) {
+                ok = false;
+                return;
+            }
+            const WorldColumn& c = columns[n];
+            ok = ok && fits(c, sizeof(arr[0]));
+            views[n++] = { ok ? data + c.offset : nullptr, ok ? static_cast<size_t>(c.count) : 0 };
+        };
+        asteroids.ForEachColumn(check);
+        projectiles.ForEachColumn(check);
+        ok = ok && n == C_WORLD_STORE_COLUMNS
+            && AsteroidStore::CheckImage(views, static_cast<size_t>(hdr.asteroidCapacity), loadSeen)
+            && ProjectileStore::CheckImage(views + AsteroidStore::COLUMN_COUNT, static_cast<size_t>(hdr.projectileCapacity));
+        // Bots are built from the config, so the image must hold exactly as many
+        const WorldColumn& botColumn = columns[C_WORLD_BOT_COLUMN];
+        ok = ok && fits(botColumn, sizeof(BotShip::BotState)) && botColumn.count == bots.size();
+        for (size_t k = 0; ok && k < bots.size(); ++k) {
+            ok = IsValidShipState(data + botColumn.offset + k * sizeof(BotShip::BotState) + offsetof(BotShip::BotState, ship));
+        }
+        if (!ok) return false;
+
+        if (asteroids.Capacity() != hdr.asteroidCapacity) asteroids.Init(static_cast<size_t>(hdr.asteroidCapacity));
+        if (projectiles.Capacity() != hdr.projectileCapacity) projectiles.Init(static_cast<size_t>(hdr.projectileCapacity));
+        n = 0;
+        auto restore = [&](auto& arr) {
+            using T = typename std::decay_t<decltype(arr)>::value_type;
+            const WorldColumn& c = columns[n++];
+            // columns are 64-byte aligned in a page-aligned mapping, so this is a straight memcpy
+            const T* src = reinterpret_cast<const T*>(data + c.offset);
+            arr.assign(src, src + c.count);
+        };
+        asteroids.ForEachColumn(restore);
+        projectiles.ForEachColumn(restore);
+
+        player->SetState(hdr.ship);
+        spawnTimer = hdr.spawnTimer;
+        points = hdr.points;
+        if (mode == Restore::FULL) {
+            tick = hdr.tick;
+            spawnRng.SetState(hdr.spawnRng);
+            timerRng.SetState(hdr.timerRng);
+            fragmentRng.SetState(hdr.fragmentRng);
+            spawnInterval = hdr.spawnInterval;
+            shotTimer = hdr.shotTimer;
+            currentWeapon = static_cast<WeaponType>(hdr.weapon);
+            currentShape = static_cast<AsteroidShape>(hdr.shape);
+            useBroadphase = hdr.broadphase != 0;
+            asteroidBounces = hdr.bounces != 0;
+            for (size_t k = 0; k < bots.size(); ++k) {
+                BotShip::BotState st;
+                memcpy(&st, data + botColumn.offset + k * sizeof(st), sizeof(st));
+                bots[k]->SetBotState(st);
+            }
+        }
+        // Both keep slot-keyed orders from before the restore
+        sweep.Clear();
+        asteroidBvh.Clear();
+        return true;
+    }
+
+    // Streams the columns straight from the stores, no staging copy
+    bool SaveWorldFile(const char* path) const {
+        WorldHeader hdr;
+        WorldColumn columns[C_WORLD_COLUMNS];
+        const size_t total = DescribeWorld(hdr, columns);
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        static const uint8_t zeros[WorldHeader::ALIGN] = {};
+        size_t written = fwrite(&hdr, 1, sizeof(hdr), f) + fwrite(columns, 1, sizeof(columns), f);
+        uint32_t n = 0;
+        auto write = [&](const auto& arr) {
+            if (n == C_WORLD_STORE_COLUMNS) return;
+            written += fwrite(zeros, 1, static_cast<size_t>(columns[n].offset) - written, f);
+            written += fwrite(arr.data(), 1, arr.size() * sizeof(arr[0]), f);
+            n++;
+        };
+        asteroids.ForEachColumn(write);
+        projectiles.ForEachColumn(write);
+        written += fwrite(zeros, 1, static_cast<size_t>(columns[C_WORLD_BOT_COLUMN].offset) - written, f);
+        for (const auto& bot : bots) {
+            const BotShip::BotState st = bot->GetBotState();
+            written += fwrite(&st, 1, sizeof(st), f);
+        }
+        written += fwrite(zeros, 1, total - written, f);
+        const bool ok = (fclose(f) == 0) && written == total;
+        return ok;
+    }
+
+    bool LoadWorldFile(const char* path) {
+        MappedFile file;
+        return file.Open(path) && LoadWorld(file.Data(), file.Size());
+    }
+
+    // Spawning follows a wave file instead of the random timer from now on;
+    // bursts fill the pool up to its capacity regardless of the field cap.
+    // False (and the timer stays) if the file cannot be opened.
+    bool LoadWaves(const char* path) {
+        waveClock = 0.f;
+        return waves.Open(path);
+    }
+
+    void WriteSnapshot(RenderSnapshot& out) const {
+        out.tick = tick;
+        out.astX.assign(asteroids.posX.begin(), asteroids.posX.end());
+        out.astY.assign(asteroids.posY.begin(), asteroids.posY.end());
+        out.astRotation.assign(asteroids.rotation.begin(), asteroids.rotation.end());
+        // Asteroids move last in a tick, at their final velocity, so the start
+        // of the tick is one step back along it
+        const size_t na = asteroids.Size();
+        out.astPrevX.resize(na);
+        out.astPrevY.resize(na);
+        out.astPrevRotation.resize(na);
+        for (size_t i = 0; i < na; ++i) {
+            out.astPrevX[i] = asteroids.posX[i] - asteroids.velX[i] * lastDt;
+            out.astPrevY[i] = asteroids.posY[i] - asteroids.velY[i] * lastDt;
+            out.astPrevRotation[i] = asteroids.rotation[i] - asteroids.rotationSpeed[i] * lastDt;
+        }
+        out.astRadius.assign(asteroids.radius.begin(), asteroids.radius.end());
+        out.astKind.assign(asteroids.kind.begin(), asteroids.kind.end());
+        out.astHpRatio.resize(asteroids.Size());
+        for (size_t i = 0; i < asteroids.Size(); ++i) {
+            out.astHpRatio[i] = asteroids.maxHP[i] > 0 ? (float)asteroids.hp[i] / (float)asteroids.maxHP[i] : 0.f;
+        }
+
+        out.projX.assign(projectiles.posX.begin(), projectiles.posX.end());
+        out.projY.assign(projectiles.posY.begin(), projectiles.posY.end());
+        out.projPrevX.assign(projectiles.prevX.begin(), projectiles.prevX.end());
+        out.projPrevY.assign(projectiles.prevY.begin(), projectiles.prevY.end());
+        out.projType.assign(projectiles.type.begin(), projectiles.type.end());
+
+        out.shipPos = player->GetPosition();
+        out.shipPrevPos = playerStart;
+        out.shipScale = player->GetScale();
+        out.shipHP = player->GetHP();
+        out.shipMaxHP = player->GetMaxHP();
+        out.shipAlive = player->IsAlive();
+        out.botPos.resize(bots.size());
+        out.botPrevPos.resize(bots.size());
+        out.botAlive.resize(bots.size());
+        for (size_t k = 0; k < bots.size(); ++k) {
+            out.botPos[k] = bots[k]->GetPosition();
+            out.botPrevPos[k] = k < botStart.size() ? botStart[k] : out.botPos[k];
+            out.botAlive[k] = bots[k]->IsAlive();
+        }
+
+        out.weapon = currentWeapon;
+        out.points = points;
+        out.broadphase = useBroadphase;
+        out.bounces = asteroidBounces;
+    }
+
+    // FNV-1a over the whole simulation state; equal hashes mean bit-identical runs
+    // Spot check of the BVH's k-nearest and radius queries against the brute
+    // force references, at a side x side grid of points over the field and a
+    // little beyond; returns how many queries disagree. Outside the tick and
+    // allowed to allocate. The index order depends only on the current field,
+    // so the check does not change the run.
+    uint64_t CheckAsteroidIndex(int side) {
+        asteroidBvh.Update(asteroids);
+        static constexpr int KS[] = { 1, 5, AsteroidBvh::MAX_K };
+        static constexpr float RADII[] = { 40.f, 160.f };
+        std::vector<int> fromIndex, fromScan;
+        uint64_t mismatches = 0;
+        for (int gy = 0; gy < side; ++gy) {
+            for (int gx = 0; gx < side; ++gx) {
+                const float x = screenW * (gx + 0.5f) / side * 1.2f - screenW * 0.1f;
+                const float y = screenH * (gy + 0.5f) / side * 1.2f - screenH * 0.1f;
+                for (int k : KS) {
+                    int rows[AsteroidBvh::MAX_K];
+                    float got[AsteroidBvh::MAX_K];
+                    float want[AsteroidBvh::MAX_K];
+                    const int n = asteroidBvh.KNearest(x, y, k, rows);
+                    for (int j = 0; j < n; ++j) {
+                        const float dx = asteroids.posX[rows[j]] - x;
+                        const float dy = asteroids.posY[rows[j]] - y;
+                        got[j] = dx * dx + dy * dy;
+                    }
+                    mismatches += n != FindKNearestBruteForce(asteroids, x, y, k, want) || !std::equal(got, got + n, want);
+                }
+                for (float r : RADII) {
+                    fromIndex.clear();
+                    fromScan.clear();
+                    asteroidBvh.Radius(x, y, r, [&](int row) { fromIndex.push_back(row); });
+                    ForEachWithinRadiusBruteForce(asteroids, x, y, r, [&](int row) { fromScan.push_back(row); });
+                    std::sort(fromIndex.begin(), fromIndex.end());
+                    mismatches += fromIndex != fromScan;
+                }
+            }
+        }
+        return mismatches;
+    }
+
+    uint64_t StateHash() const {
+        uint64_t h = 1469598103934665603ull;
+        auto mix = [&h](const void* data, size_t bytes) {
+            const uint8_t* p = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < bytes; ++i) {
+                h = (h ^ p[i]) * 1099511628211ull;
+            }
+        };
+        auto mixArray = [&mix](const auto& arr) {
+            mix(arr.data(), arr.size() * sizeof(arr[0]));
+        };
+        mixArray(asteroids.posX); mixArray(asteroids.posY);
+        mixArray(asteroids.velX); mixArray(asteroids.velY);
+        mixArray(asteroids.rotation); mixArray(asteroids.hp);
+        mixArray(asteroids.kind); mixArray(asteroids.size);
+        mixArray(projectiles.posX); mixArray(projectiles.posY);
+        mixArray(projectiles.velX); mixArray(projectiles.velY);
+        mixArray(projectiles.type);
+        Vector2 shipPos = player->GetPosition();
+        int shipHP = player->GetHP();
+        mix(&shipPos, sizeof(shipPos));
+        mix(&shipHP, sizeof(shipHP));
+        mix(&points, sizeof(points));
+        mix(&spawnTimer, sizeof(spawnTimer));
+        mix(&shotTimer, sizeof(shotTimer));
+        for (const auto& bot : bots) {
+            Ship::State st = bot->GetState();
+            mix(&st.position, sizeof(st.position));
+            mix(&st.hp, sizeof(st.hp));
+        }
+        return h;
+    }
+
+    const PlayerShip& Player() const {
+        return *player;
+    }
+
+    const AsteroidStore& Asteroids() const {
+        return asteroids;
+    }
+
+    const ProjectileStore& Projectiles() const {
+        return projectiles;
+    }
+
+    size_t BotCount() const {
+        return bots.size();
+    }
+
+    const FragmentQueue& Fragments() const {
+        return fragments;
+    }
+
+    // Hits and destructions of the last Step(), for effects
+    const std::vector<ImpactEvent>& Impacts() const {
+        return impacts;
+    }
+
+    WeaponType CurrentWeapon() const {
+        return currentWeapon;
+    }
+
+    int Points() const {
+        return points;
+    }
+
+    bool UsesBroadphase() const {
+        return useBroadphase;
+    }
+
+    bool UsesBounces() const {
+        return asteroidBounces;
+    }
+
+    uint64_t Tick() const {
+        return tick;
+    }
+
+private:
+    // Enum and flag bytes in range and a sane projectile capacity (the asteroid
+    // one is bounded by its slot tables fitting in the file). Ships' alive
+    // flags are checked as raw bytes, since a bool holding anything but 0 or 1
+    // is not a valid value.
+    static bool IsValidWorldHeader(const WorldHeader& hdr, const uint8_t* data) {
+        return hdr.weapon < static_cast<uint8_t>(WeaponType::COUNT)
+            && (hdr.shape < ASTEROID_KIND_COUNT || hdr.shape == static_cast<uint8_t>(AsteroidShape::RANDOM))
+            && hdr.broadphase <= 1 && hdr.bounces <= 1 && IsValidShipState(data + offsetof(WorldHeader, ship))
+            && hdr.projectileCapacity <= C_WORLD_MAX_PROJECTILES;
+    }
+
+    // state points at a raw Ship::State in an image
+    static bool IsValidShipState(const uint8_t* state) {
+        uint8_t alive;
+        memcpy(&alive, state + offsetof(Ship::State, alive), sizeof(alive));
+        return alive <= 1;
+    }
+
+    // Fills the header and column table; returns the total image size
+    size_t DescribeWorld(WorldHeader& hdr, WorldColumn* columns) const {
+        memset(&hdr, 0, sizeof(hdr));
+        memcpy(hdr.magic, WorldHeader::MAGIC, sizeof(hdr.magic));
+        hdr.version = WorldHeader::VERSION;
+        hdr.headerBytes = sizeof(WorldHeader);
+        hdr.tick = tick;
+        hdr.asteroidCapacity = asteroids.Capacity();
+        hdr.projectileCapacity = projectiles.Capacity();
+        hdr.spawnRng = spawnRng.GetState();
+        hdr.timerRng = timerRng.GetState();
+        hdr.fragmentRng = fragmentRng.GetState();
+        hdr.ship = player->GetState();
+        hdr.spawnTimer = spawnTimer;
+        hdr.spawnInterval = spawnInterval;
+        hdr.shotTimer = shotTimer;
+        hdr.points = points;
+        hdr.weapon = static_cast<uint8_t>(currentWeapon);
+        hdr.shape = static_cast<uint8_t>(currentShape);
+        hdr.broadphase = useBroadphase;
+        hdr.bounces = asteroidBounces;
+
+        memset(columns, 0, C_WORLD_COLUMNS * sizeof(WorldColumn));
+        uint32_t n = 0;
+        size_t offset = AlignWorld(sizeof(WorldHeader) + C_WORLD_COLUMNS * sizeof(WorldColumn));
+        auto describe = [&](const auto& arr) {
+            if (n == C_WORLD_STORE_COLUMNS) return; // table out of date, LoadWorld will reject the count
+            columns[n] = { offset, arr.size(), sizeof(arr[0]), 0 };
+            offset = AlignWorld(offset + arr.size() * sizeof(arr[0]));
+            n++;
+        };
+        asteroids.ForEachColumn(describe);
+        projectiles.ForEachColumn(describe);
+        if (n == C_WORLD_BOT_COLUMN) {
+            columns[n++] = { offset, bots.size(), sizeof(BotShip::BotState), 0 };
+            offset = AlignWorld(offset + bots.size() * sizeof(BotShip::BotState));
+        }
+        hdr.columnCount = n;
+        return offset;
+    }
+
+    // Back to the state captured at construction, without rebuilding anything.
+    // A wave file starts over too.
+    void Restart() {
+        LoadWorld(restartImage.data(), restartImage.size(), Restore::RESTART);
+        spawnInterval = timerRng.Float(config.spawnMin, config.spawnMax);
+        for (auto& bot : bots) {
+            bot->Respawn();
+        }
+        if (waves.IsOpen()) {
+            waves.Rewind();
+            waveClock = 0.f;
+        }
     }
 
-    virtual float GetRadius() const = 0;
+    size_t SpawnUpToLimit(size_t count, AsteroidShape shape) {
+        const size_t limit = spawnCap;
+        const size_t room = asteroids.Size() < limit ? limit - asteroids.Size() : 0;
+        return asteroids.SpawnBatch(std::min(count, room), screenW, screenH, shape, spawnRng);
+    }
 
-    int GetHP() const {
-        return hp;
+    // Fires weapon from the ship's nose for as many shots as fit in the time
+    // held; a released trigger keeps less than one interval of the timer
+    void Fire(const Ship& ship, WeaponType weapon, bool firing, float dt, float& timer) {
+        const float interval = 1.f / (ship.GetFireRate(weapon) * config.fireRateScale);
+        if (firing) {
+            timer += dt;
+            float projSpeed = ship.GetSpacing(weapon) * ship.GetFireRate(weapon);
+
+            while (timer >= interval) {
+                Vector2 p = ship.GetPosition();
+                p.y -= ship.GetRadius();
+                projectiles.Emit(weapon, p, projSpeed);
+                timer -= interval;
+            }
+        }
+        else if (timer > interval) {
+            timer = fmodf(timer, interval);
+        }
     }
 
-    int GetMaxHP() const {
-        return maxHP;
+    // All homing projectiles look up their nearest asteroid in one batch query.
+    // Each keeps chasing its current target unless that is gone or clearly
+    // further than the nearest one (the query only looks inside that distance),
+    // and turns toward it at a bounded rate, keeping its speed. Close in the
+    // limit is lifted, so a missile cannot end up circling its target. Every
+    // projectile only writes its own row.
+    void SteerHoming(float dt) {
+        homingRows.clear();
+        const size_t n = projectiles.Size();
+        for (size_t p = 0; p < n; ++p) {
+            if (projectiles.type[p] == static_cast<uint8_t>(WeaponType::HOMING)) {
+                homingRows.push_back(static_cast<uint32_t>(p));
+            }
+        }
+        if (homingRows.empty() || asteroids.Size() == 0) {
+            return;
+        }
+
+        const size_t m = homingRows.size();
+        homingX.resize(m);
+        homingY.resize(m);
+        homingLimitSq.resize(m);
+        homingNearest.resize(m);
+        for (size_t i = 0; i < m; ++i) {
+            const size_t p = homingRows[i];
+            homingX[i] = projectiles.posX[p];
+            homingY[i] = projectiles.posY[p];
+            // Only an asteroid clearly closer than the current target is of interest
+            const long long row = asteroids.IndexOf(projectiles.target[p]);
+            homingLimitSq[i] = INFINITY;
+            if (row >= 0) {
+                const float dx = asteroids.posX[row] - homingX[i];
+                const float dy = asteroids.posY[row] - homingY[i];
+                homingLimitSq[i] = (dx * dx + dy * dy) * C_HOMING_RETARGET_SCALE;
+            }
+        }
+        if (useBroadphase) {
+            asteroidBvh.Update(asteroids);
+        }
+
+        const float cosTurn = cosf(C_HOMING_TURN_RATE * dt);
+        const float sinTurn = sinf(C_HOMING_TURN_RATE * dt);
+        JobSystem::Instance().ParallelFor(m, C_GRAIN_HOMING, [this, cosTurn, sinTurn](size_t b, size_t e) {
+            if (useBroadphase) {
+                asteroidBvh.NearestBatch(homingX.data() + b, homingY.data() + b, homingLimitSq.data() + b,
+                    e - b, homingNearest.data() + b);
+            }
+            else {
+                for (size_t i = b; i < e; ++i) {
+                    homingNearest[i] = FindNearestBruteForce(asteroids, homingX[i], homingY[i], homingLimitSq[i]);
+                }
+            }
+            for (size_t i = b; i < e; ++i) {
+                const size_t p = homingRows[i];
+                if (homingNearest[i] >= 0) {
+                    projectiles.target[p] = asteroids.HandleAt(static_cast<size_t>(homingNearest[i]));
+                }
+                // No live target (NaN position, nothing within the limit): fly straight
+                const long long row = asteroids.IndexOf(projectiles.target[p]);
+                if (row < 0) {
+                    continue;
+                }
+                const float dx = asteroids.posX[row] - homingX[i];
+                const float dy = asteroids.posY[row] - homingY[i];
+                const float vx = projectiles.velX[p];
+                const float vy = projectiles.velY[p];
+                const float distSq = dx * dx + dy * dy;
+                const float speedSq = vx * vx + vy * vy;
+                if (distSq <= 0.f || speedSq <= 0.f) {
+                    continue;
+                }
+                const float dot = vx * dx + vy * dy;
+                if (distSq <= C_HOMING_LOCK_DISTANCE * C_HOMING_LOCK_DISTANCE || dot >= cosTurn * sqrtf(speedSq * distSq)) {
+                    const float scale = sqrtf(speedSq / distSq);
+                    projectiles.velX[p] = dx * scale;
+                    projectiles.velY[p] = dy * scale;
+                }
+                else {
+                    const float sn = (vx * dy - vy * dx >= 0.f) ? sinTurn : -sinTurn;
+                    projectiles.velX[p] = vx * cosTurn - vy * sn;
+                    projectiles.velY[p] = vx * sn + vy * cosTurn;
+                }
+            }
+        });
     }
 
-    float GetFireRate(WeaponType wt) const {
-        return (wt == WeaponType::LASER) ? fireRateLaser : fireRateBullet;
+    // Bots decide in parallel against the current field, then move and fire
+    // serially in bot order so projectile order does not depend on threads
+    void UpdateBots(float dt) {
+        botInput.resize(bots.size());
+        JobSystem::Instance().ParallelFor(bots.size(), C_GRAIN_BOTS, [this](size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k) {
+                botInput[k] = bots[k]->Decide(asteroids, [this](Vector2 pos, float radius, auto&& fn) {
+                    ForEachAsteroidNear(pos, radius, fn);
+                });
+            }
+        });
+        botStart.resize(bots.size());
+        for (size_t k = 0; k < bots.size(); ++k) {
+            BotShip& bot = *bots[k];
+            const bool wasAlive = bot.IsAlive();
+            botStart[k] = bot.GetPosition();
+            bot.Update(dt, botInput[k]);
+            if (!wasAlive) {
+                botStart[k] = bot.GetPosition(); // a respawn is a jump, not a move
+            }
+            Fire(bot, bot.GetWeapon(), bot.IsAlive() && botInput[k].fire, dt, bot.ShotTimer());
+        }
     }
 
-    float GetSpacing(WeaponType wt) const {
-        return (wt == WeaponType::LASER) ? spacingLaser : spacingBullet;
+    // Grid query when it is in use, plain scan otherwise
+    template <typename Fn>
+    void ForEachAsteroidNear(Vector2 pos, float radius, Fn&& fn) const {
+        if (useBroadphase) {
+            grid.ForEachNear(asteroids, pos, radius, fn);
+            return;
+        }
+        for (size_t i = 0; i < asteroids.Size(); ++i) {
+            const float reach = radius + asteroids.radius[i];
+            if (fabsf(asteroids.posX[i] - pos.x) <= reach && fabsf(asteroids.posY[i] - pos.y) <= reach) {
+                fn(i);
+            }
+        }
     }
 
-protected:
-    TransformA transform;
-    int        hp;
-    int        maxHP;
-    float      speed;
-    bool       alive;
-    float      fireRateLaser;
-    float      fireRateBullet;
-    float      spacingLaser;
-    float      spacingBullet;
+    // 0 is the player, 1.. the bots
+    Ship& ShipAt(uint32_t s) {
+        return s == 0 ? static_cast<Ship&>(*player) : static_cast<Ship&>(*bots[s - 1]);
+    }
+
+    // Flags every asteroid touching a live ship and remembers which ship it
+    // touched first, in ship order
+    void TestShips(bool sweepReady) {
+        const size_t n = asteroids.Size();
+        hitShip.assign(n, NO_SHIP);
+        const uint32_t ships = static_cast<uint32_t>(bots.size()) + 1;
+        for (uint32_t s = 0; s < ships; ++s) {
+            const Ship& ship = ShipAt(s);
+            if (!ship.IsAlive()) continue;
+            const Vector2 pos = ship.GetPosition();
+            const float radius = ship.GetRadius();
+            auto test = [&](size_t i) {
+                if (hitShip[i] != NO_SHIP) return;
+                if (Vector2Distance(pos, asteroids.GetPosition(i)) < radius + asteroids.radius[i]) {
+                    hitShip[i] = s;
+                    asteroidDead[i] = 1;
+                }
+            };
+            if (sweepReady) {
+                sweep.QueryX(pos.x - radius, pos.x + radius, test);
+            }
+            else {
+                for (size_t i = 0; i < n; ++i) test(i);
+            }
+        }
+    }
+
+    // Impact point on the asteroid's surface facing from; past the cap the
+    // event is dropped, it is only cosmetic
+    void RecordImpact(size_t i, Vector2 from, bool destroyed) {
+        if (impacts.size() == C_MAX_IMPACTS) return;
+        const Vector2 center = asteroids.GetPosition(i);
+        Vector2 dir = Vector2Subtract(from, center);
+        const float len = Vector2Length(dir);
+        dir = len > 0.f ? Vector2Scale(dir, 1.f / len) : Vector2{ 0.f, -1.f };
+        const float r = destroyed ? 0.f : asteroids.radius[i];
+        impacts.push_back({ center.x + dir.x * r, center.y + dir.y * r, dir.x, dir.y,
+            asteroids.velX[i], asteroids.velY[i], asteroids.kind[i], asteroids.size[i], destroyed });
+    }
+
+    static size_t AlignWorld(size_t offset) {
+        return (offset + WorldHeader::ALIGN - 1) & ~(WorldHeader::ALIGN - 1);
+    }
+
+    int FindEarliestHit(size_t p) const {
+        Vector2 from = projectiles.GetPrevPosition(p);
+        Vector2 to = projectiles.GetPosition(p);
+        return useBroadphase
+            ? grid.QueryEarliest(asteroids, asteroidDead, from, to, projectiles.radius[p])
+            : FindEarliestHitBruteForce(asteroids, asteroidDead, from, to, projectiles.radius[p]);
+    }
+
+    int              screenW;
+    int              screenH;
+    SimulationConfig config;
+
+    Rng spawnRng;
+    Rng timerRng;
+    Rng fragmentRng;
+
+    std::unique_ptr<PlayerShip> player;
+    std::vector<std::unique_ptr<BotShip>> bots;
+    AsteroidStore               asteroids;
+    ProjectileStore             projectiles;
+    FragmentQueue               fragments;
+
+    AsteroidShape currentShape = AsteroidShape::TRIANGLE;
+    WeaponType    currentWeapon = WeaponType::LASER;
+
+    uint64_t tick = 0;
+    float    spawnTimer = 0.f;
+    float    spawnInterval = 0.f;
+    float    shotTimer = 0.f;
+    int      points = 0; // Added points counter
+    size_t   spawnCap = config.maxAsteroidsOnField; // lowered by InputState::spawnLevel
+    float    lastDt = 0.f;
+    Vector2  playerStart{}; // ship positions at the start of the tick, for interpolated drawing
+    std::vector<Vector2> botStart;
+
+    CollisionGrid        grid;
+    SweepAndPrune        sweep;
+    AsteroidBvh          asteroidBvh;
+    std::vector<uint32_t> homingRows; // projectile rows of type HOMING
+    std::vector<float>   homingX;
+    std::vector<float>   homingY;
+    std::vector<float>   homingLimitSq;
+    std::vector<int>     homingNearest;
+    std::vector<uint8_t> asteroidDead;
+    std::vector<uint8_t> projectileHit;
+    std::vector<uint8_t> boundsMask;
+    std::vector<int>     projectileTarget;
+    bool                 useBroadphase = C_USE_BROADPHASE;
+    bool                 asteroidBounces;
+    std::vector<uint8_t> restartImage; // world as constructed, restored on restart
+    std::vector<uint8_t> loadSeen;     // slot marks while a world image is checked
+    WaveScheduler        waves;
+    float                waveClock = 0.f; // seconds since the wave file started
+    std::vector<ImpactEvent> impacts;
+    std::vector<InputState>  botInput;
+    std::vector<uint32_t>    hitShip; // per asteroid, ShipAt() index or NO_SHIP
+
+    static constexpr bool C_USE_BROADPHASE = true;
+    static constexpr size_t C_MAX_IMPACTS = 4096; // per tick
+    // Of maxAsteroidsOnField per InputState::spawnLevel. Recordings are checked
+    // on load, so a level always indexes this.
+    static constexpr float C_SPAWN_LEVEL_SCALE[InputState::SPAWN_LEVELS] = { 1.f, 0.75f, 0.5f };
+    static constexpr size_t C_GRAIN_BOTS = 8;
+    static constexpr float C_HOMING_TURN_RATE = 5.f;       // rad/s
+    static constexpr float C_HOMING_LOCK_DISTANCE = 60.f;  // px, steer straight at the target inside this
+    static constexpr float C_HOMING_RETARGET_SCALE = 0.64f; // squared distance ratio: switch to an asteroid 0.8x as far
+    static constexpr uint32_t NO_SHIP = 0xFFFFFFFFu;
+    static constexpr uint32_t C_WORLD_STORE_COLUMNS = AsteroidStore::COLUMN_COUNT + ProjectileStore::COLUMN_COUNT;
+    static constexpr uint32_t C_WORLD_BOT_COLUMN = C_WORLD_STORE_COLUMNS; // after the stores
+    static constexpr uint32_t C_WORLD_COLUMNS = C_WORLD_BOT_COLUMN + 1;
+    static constexpr uint64_t C_WORLD_MAX_PROJECTILES = 1u << 22;
+
+    // Chunk sizes for the job system; multiples of the widest SIMD lane count
+    static constexpr size_t C_GRAIN_INTEGRATE = 4096;
+    static constexpr size_t C_GRAIN_COLLIDE = 256;
+    static constexpr size_t C_GRAIN_HOMING = 256;
 };
 
-class PlayerShip :public Ship {
-public:
-    PlayerShip(int w, int h) : Ship(w, h) {
-        texture = LoadTexture("spaceship.png");
-        GenTextureMipmaps(&texture);
-        SetTextureFilter(texture, 2);
-        scale = 0.25f;
+// --- BENCHMARK SCENARIOS ---
+// Headless stress loads for --bench. Each drives the real Step() with an
+// invulnerable ship that strafes and holds fire, so the load stays up.
+struct BenchScenario {
+    const char* name;
+    size_t      maxAsteroids;
+    float       spawnInterval;
+    int         spawnBurst;
+    size_t      projectileCapacity;
+    float       fireRateScale;
+    WeaponType  weapon;
+    bool        cycleWeapons;
+    bool        bounces;
+    int         bots;
+
+    SimulationConfig Config() const {
+        SimulationConfig c;
+        c.maxAsteroidsOnField = maxAsteroids;
+        c.spawnMin = spawnInterval;
+        c.spawnMax = spawnInterval;
+        c.spawnBurst = spawnBurst;
+        c.asteroidCapacity = maxAsteroids;
+        c.projectileCapacity = projectileCapacity;
+        c.fireRateScale = fireRateScale;
+        c.invulnerable = true;
+        c.startWeapon = weapon;
+        c.asteroidBounces = bounces;
+        c.bots = bots;
+        return c;
     }
-    ~PlayerShip() {
-        UnloadTexture(texture);
+};
+
+static constexpr BenchScenario BENCH_SCENARIOS[] = {
+    // name             asteroids interval burst projectiles  fire x  weapon                   cycle  bounces bots
+    { "asteroid_swarm",    10'000,   0.f,  200,     10'000,    1.f, WeaponType::LASER,        false, false,    0 },
+    { "bullet_storm",         150,   0.5f,   1,    150'000, 2500.f, WeaponType::BULLET,       false, false,    0 },
+    { "side_blaster_sat",   1'000,   0.05f,  5,    100'000, 2000.f, WeaponType::SIDE_BLASTER, false, false,    0 },
+    { "mixed",              5'000,   0.f,   50,    100'000,  500.f, WeaponType::LASER,        true,  false,    0 },
+    { "asteroid_bounces",  10'000,   0.f,  200,     10'000,    1.f, WeaponType::LASER,        false, true,     0 },
+    { "bot_swarm",          2'000,   0.f,   20,    100'000,    1.f, WeaponType::LASER,        false, false,  200 },
+    { "homing_swarm",       5'000,   0.f,   50,    100'000,  300.f, WeaponType::HOMING,       false, false,    0 },
+};
+
+// --- FRAME GOVERNOR ---
+// Holds the windowed game to a frame-time budget by shedding optional work,
+// what the player misses least first, and brings it back once there is
+// headroom. It watches a smoothed frame cost; a change needs that cost to stay
+// past a threshold for a run of frames and is followed by a cooldown, so one
+// slow frame changes nothing and levels do not flap. Every change is logged.
+class FrameGovernor {
+public:
+    enum Level : int {
+        LEVEL_FULL,
+        LEVEL_NO_HP_BARS,
+        LEVEL_FEWER_PARTICLES,
+        LEVEL_NO_PARTICLES,
+        LEVEL_FEWER_ASTEROIDS, // spawn cap at 75 % of the configured maximum
+        LEVEL_HALF_ASTEROIDS,  // 50 %
+        LEVEL_COUNT
+    };
+
+    void SetBudget(float ms) {
+        budgetMs = ms;
     }
 
-    void Update(float dt) override {
-        if (alive) {
-            if (IsKeyDown(KEY_W)) transform.position.y -= speed * dt;
-            if (IsKeyDown(KEY_S)) transform.position.y += speed * dt;
-            if (IsKeyDown(KEY_A)) transform.position.x -= speed * dt;
-            if (IsKeyDown(KEY_D)) transform.position.x += speed * dt;
+    // Feeds one frame's cost: the work done for it, not time spent waiting
+    void Observe(float frameMs) {
+        smoothedMs = (smoothedMs <= 0.f) ? frameMs : smoothedMs + (frameMs - smoothedMs) * C_SMOOTHING;
+        if (cooldown > 0) {
+            cooldown--;
+            return;
+        }
+        if (smoothedMs > budgetMs * C_DEGRADE_AT) {
+            overRun++;
+            underRun = 0;
+        }
+        else if (smoothedMs < budgetMs * C_RESTORE_AT) {
+            underRun++;
+            overRun = 0;
         }
         else {
-            transform.position.y += speed * dt;
+            overRun = 0;
+            underRun = 0;
+        }
+
+        if (overRun >= C_DEGRADE_FRAMES && level + 1 < LEVEL_COUNT) {
+            Change(level + 1);
+        }
+        else if (underRun >= C_RESTORE_FRAMES && level > LEVEL_FULL) {
+            Change(level - 1);
         }
     }
 
-    void Draw() const override {
-        if (!alive && fmodf(GetTime(), 0.4f) > 0.2f) return;
-        Vector2 dstPos = {
-            transform.position.x - (texture.width * scale) * 0.5f,
-            transform.position.y - (texture.height * scale) * 0.5f
-        };
-        DrawTextureEx(texture, dstPos, 0.0f, scale, WHITE);
+    int GetLevel() const {
+        return level;
+    }
 
+    float SmoothedMs() const {
+        return smoothedMs;
+    }
 
-        float barWidth = 200.f;
-        float hpPercent = (float)GetHP() / (float)GetMaxHP();
-        Rectangle backBar = { 10, 10, barWidth, 20 };
-        Rectangle hpBar = { 10, 10, barWidth * hpPercent, 20 };
-        DrawRectangleRec(backBar, RED);
-        DrawRectangleRec(hpBar, BLUE);
-        DrawText(TextFormat("%d/%d", GetHP(), GetMaxHP()), 20, 10, 20, BLACK);
+    float BudgetMs() const {
+        return budgetMs;
     }
 
-    float GetRadius() const override {
-        return (texture.width * scale) * 0.5f;
+    uint32_t Changes() const {
+        return changes;
+    }
+
+    bool DrawHpBars() const {
+        return level < LEVEL_NO_HP_BARS;
+    }
+
+    // Share of the usual particle count emitted per impact
+    float ParticleDensity() const {
+        return level >= LEVEL_NO_PARTICLES ? 0.f : level >= LEVEL_FEWER_PARTICLES ? 0.5f : 1.f;
+    }
+
+    // InputState::spawnLevel to send. It travels with the input, so a recording
+    // replays the same asteroid cap whatever the replaying machine's governor does.
+    int SpawnLevel() const {
+        static_assert(LEVEL_HALF_ASTEROIDS - LEVEL_FEWER_ASTEROIDS + 2 == InputState::SPAWN_LEVELS,
+            "one spawn level per asteroid governor level, plus the full cap");
+        return level >= LEVEL_HALF_ASTEROIDS ? 2 : level >= LEVEL_FEWER_ASTEROIDS ? 1 : 0;
+    }
+
+    static const char* LevelName(int l) {
+        static const char* const NAMES[LEVEL_COUNT] = {
+            "full", "no hp bars", "half particles", "no particles", "asteroid cap 75%", "asteroid cap 50%"
+        };
+        return NAMES[l];
     }
 
 private:
-    Texture2D texture;
-    float     scale;
+    void Change(int to) {
+        TraceLog(LOG_INFO, "Governor: frame %.2f ms against a %.2f ms budget, %s -> %s",
+            smoothedMs, budgetMs, LevelName(level), LevelName(to));
+        level = to;
+        overRun = 0;
+        underRun = 0;
+        cooldown = C_COOLDOWN_FRAMES;
+        changes++;
+    }
+
+    static constexpr float C_SMOOTHING = 0.1f;  // weight of the newest frame
+    static constexpr float C_DEGRADE_AT = 0.9f; // of the budget
+    static constexpr float C_RESTORE_AT = 0.6f;
+    static constexpr int   C_DEGRADE_FRAMES = 30;
+    static constexpr int   C_RESTORE_FRAMES = 120;
+    static constexpr int   C_COOLDOWN_FRAMES = 60; // lets a change show in the smoothed cost
+
+    float    budgetMs = 1000.f / 60.f;
+    float    smoothedMs = 0.f;
+    int      level = LEVEL_FULL;
+    int      overRun = 0;  // consecutive frames over the degrade threshold
+    int      underRun = 0; // and under the restore threshold
+    int      cooldown = 0;
+    uint32_t changes = 0;
 };
 
 // --- APPLICATION ---
+// Command line settings shared by the windowed and headless entry points
+struct LaunchOptions {
+    long long   headlessTicks = -1; // < 0: windowed
+    float       dt = 1.f / 60.f;
+    const char* profileCsvPath = nullptr;
+    const char* tracePath = nullptr;
+    int         threads = -1; // job system workers, -1: one per spare core
+    bool        pipelined = true; // windowed: simulate on a separate thread
+    uint64_t    seed = 0;
+    bool        hasSeed = false; // otherwise time-based windowed, fixed headless
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    const char* wavesPath = nullptr;
+    bool        bounces = false; // asteroid-asteroid collisions from the start
+    int         bots = 0;
+    const char* saveWorldPath = nullptr;
+    const char* loadWorldPath = nullptr;
+    const char* benchName = nullptr; // scenario name or "all"
+    long long   benchTicks = 1000;   // measured ticks per scenario, after warm-up
+    int         fps = 60;            // windowed frame cap, 0 = uncapped
+    bool        governor = true;     // shed optional work to hold the frame budget
+};
+
 class Application {
 public:
     static Application& Instance() {
@@ -452,208 +5131,692 @@ public:
         return inst;
     }
 
-    void Run() {
-        srand(static_cast<unsigned>(time(nullptr)));
-        Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Asteroids OOP");
+    void Run(const LaunchOptions& opts) {
+        Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Asteroids OOP", opts.fps);
+        governor.SetBudget(1000.f / static_cast<float>(opts.fps > 0 ? opts.fps : C_BUDGET_FPS));
 
-        // Load background texture
-        Texture2D background = LoadTexture("background.jpg");
-        if (background.id == 0) {
-            TraceLog(LOG_WARNING, "Failed to load background.jpg, using black background");
+        InputRecording replay;
+        const bool replaying = opts.replayPath != nullptr;
+        if (replaying && !replay.Load(opts.replayPath)) {
+            TraceLog(LOG_ERROR, "Failed to load replay %s (missing, corrupt or an older format)", opts.replayPath);
+            return;
         }
-
-        auto player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
-
-        float spawnTimer = 0.f;
-        float spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-        WeaponType currentWeapon = WeaponType::LASER;
-        float shotTimer = 0.f;
-        int points = 0; // Added points counter
-
-        while (!WindowShouldClose()) {
-            float dt = GetFrameTime();
-            spawnTimer += dt;
-
-            // Update player
-            player->Update(dt);
-
-            // Restart logic
-            if (!player->IsAlive() && IsKeyPressed(KEY_R)) {
-                player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
-                asteroids.clear();
-                projectiles.clear();
-                spawnTimer = 0.f;
-                spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-                points = 0; // Reset points on restart
-            }
-            // Asteroid shape switch
-            if (IsKeyPressed(KEY_ONE)) {
-                currentShape = AsteroidShape::TRIANGLE;
+        const InputRecording::Settings settings = RecordedSettings(opts);
+        if (replaying) {
+            if (const char* diff = SettingsMismatch(replay.GetSettings(), settings)) {
+                TraceLog(LOG_ERROR, "Replay %s was recorded with a different %s", opts.replayPath, diff);
+                return;
             }
-            if (IsKeyPressed(KEY_TWO)) {
-                currentShape = AsteroidShape::SQUARE;
-            }
-            if (IsKeyPressed(KEY_THREE)) {
-                currentShape = AsteroidShape::PENTAGON;
-            }
-            if (IsKeyPressed(KEY_FIVE)) {
-                currentShape = AsteroidShape::REDHEAVY;
+        }
+        // Logged so an interesting session can be replayed with --seed
+        const uint64_t seed = replaying ? replay.Seed()
+            : opts.hasSeed ? opts.seed : static_cast<uint64_t>(time(nullptr));
+        TraceLog(LOG_INFO, "Simulation seed: %llu", (unsigned long long)seed);
+        // The simulation always steps at a fixed dt; frames in between are
+        // drawn interpolated between the last two ticks
+        const float stepDt = replaying ? replay.Dt() : C_SIM_DT;
+
+        InputRecording recording;
+        recording.Begin(seed, stepDt, settings);
+        size_t replayTick = 0;
+        bool replayDone = false;
+        // Input for the next tick: live, or from the replay. False once the replay has run out.
+        auto nextInput = [&](const InputState& live, InputState& in) {
+            if (replaying) {
+                if (replayTick >= replay.TickCount()) return false;
+                in = replay.At(replayTick++);
             }
-            if (IsKeyPressed(KEY_FOUR)) {
-                currentShape = AsteroidShape::RANDOM;
+            else {
+                in = live;
             }
+            if (opts.recordPath) recording.Append(in);
+            return true;
+        };
 
-            // Weapon switch
-            if (IsKeyPressed(KEY_TAB)) {
-                currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
-            }
+        // Textures belong to the render side; the simulation only needs sizes
+        LoadAssets();
+        particles.Init(C_MAX_PARTICLES);
+        ImpactLatch impacts(C_MAX_IMPACT_BACKLOG);
 
-            // Shooting
-            {
-                if (player->IsAlive() && IsKeyDown(KEY_SPACE)) {
-                    shotTimer += dt;
-                    float interval = 1.f / player->GetFireRate(currentWeapon);
-                    float projSpeed = player->GetSpacing(currentWeapon) * player->GetFireRate(currentWeapon);
-
-                    while (shotTimer >= interval) {
-                        Vector2 p = player->GetPosition();
-                        p.y -= player->GetRadius();
-                        auto shots = MakeProjectile(currentWeapon, p, projSpeed);
-                        projectiles.insert(projectiles.end(), shots.begin(), shots.end());
-                        shotTimer -= interval;
+        SimulationConfig config;
+        config.asteroidBounces = opts.bounces;
+        config.bots = opts.bots;
+        Simulation sim(C_WIDTH, C_HEIGHT, seed, config);
+        if (opts.loadWorldPath && !LoadWorld(sim, opts.loadWorldPath)) {
+            return;
+        }
+        if (opts.wavesPath && !sim.LoadWaves(opts.wavesPath)) {
+            TraceLog(LOG_ERROR, "Failed to open wave file %s", opts.wavesPath);
+            return;
+        }
+        SnapshotBuffer snapshots;
+        Profiler& profiler = Profiler::Instance();
+
+        InputLatch latch;
+        if (opts.pipelined) {
+            // The simulation ticks at a fixed rate on its own thread and publishes
+            // a snapshot per tick; this thread only polls input and draws.
+            // Ticks that fell due while the thread was busy are caught up, a few
+            // at most; past that the backlog is dropped and the game runs slow
+            // rather than spending ever longer catching up.
+            std::atomic<bool> running{ true };
+            std::atomic<float> simTickMs{ 0.f };
+            std::thread simThread([&] {
+                using Clock = std::chrono::steady_clock;
+                const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(stepDt));
+                auto next = Clock::now();
+                while (running.load(std::memory_order_relaxed)) {
+                    for (int steps = 0; steps < C_MAX_CATCHUP_TICKS && next <= Clock::now(); ++steps) {
+                        InputState in;
+                        if (nextInput(latch.Take(), in)) {
+                            const auto t0 = Clock::now();
+                            profiler.BeginFrame();
+                            sim.Step(stepDt, in);
+                            profiler.EndFrame(sim.Asteroids().Size(), sim.Projectiles().Size());
+                            simTickMs.store(static_cast<float>(MillisSince(t0)), std::memory_order_relaxed);
+                            sim.WriteSnapshot(snapshots.Back());
+                            snapshots.Back().publishedAt = Now();
+                            snapshots.Publish();
+                            impacts.Push(sim.Impacts());
+                        }
+                        else if (!replayDone) {
+                            replayDone = true;
+                            ReportReplay(sim);
+                        }
+                        next += period;
+                    }
+
+                    auto now = Clock::now();
+                    if (next < now) {
+                        droppedTicks.fetch_add(static_cast<uint64_t>((now - next) / period), std::memory_order_relaxed);
+                        next = now;
                     }
+                    std::this_thread::sleep_until(next);
                 }
-                else {
-                    float maxInterval = 1.f / player->GetFireRate(currentWeapon);
+            });
 
-                    if (shotTimer > maxInterval) {
-                        shotTimer = fmodf(shotTimer, maxInterval);
+            while (!WindowShouldClose()) {
+                latch.Push(PollInput());
+                if (IsKeyPressed(KEY_F3)) {
+                    profiler.ToggleOverlay();
+                }
+                const RenderSnapshot& snap = snapshots.Acquire();
+                const float alpha = static_cast<float>((Now() - snap.publishedAt) / stepDt);
+                snap.Interpolate(std::clamp(alpha, 0.f, 1.f), frame);
+                DrawSnapshot(frame, impacts.Take());
+                Govern(opts, std::max(static_cast<float>(renderWorkMs), simTickMs.load(std::memory_order_relaxed)));
+            }
+            running = false;
+            simThread.join();
+        }
+        else {
+            // Fixed-step accumulator on the render thread: as many ticks as the
+            // frame time covers, a few at most, and the remainder interpolated
+            float accumulator = 0.f;
+            while (!WindowShouldClose()) {
+                profiler.BeginFrame();
+                if (IsKeyPressed(KEY_F3)) {
+                    profiler.ToggleOverlay();
+                }
+                latch.Push(PollInput());
+                const auto t0 = std::chrono::steady_clock::now();
+                accumulator += GetFrameTime();
+                for (int steps = 0; steps < C_MAX_CATCHUP_TICKS && accumulator >= stepDt; ++steps) {
+                    accumulator -= stepDt;
+                    InputState in;
+                    if (nextInput(latch.Take(), in)) {
+                        sim.Step(stepDt, in);
+                        sim.WriteSnapshot(snapshots.Back());
+                        snapshots.Publish();
+                        impacts.Push(sim.Impacts());
+                    }
+                    else if (!replayDone) {
+                        replayDone = true;
+                        ReportReplay(sim);
                     }
                 }
+                if (accumulator >= stepDt) {
+                    droppedTicks.fetch_add(static_cast<uint64_t>(accumulator / stepDt), std::memory_order_relaxed);
+                    accumulator = fmodf(accumulator, stepDt);
+                }
+                const double simMs = MillisSince(t0);
+
+                snapshots.Acquire().Interpolate(accumulator / stepDt, frame);
+                DrawSnapshot(frame, impacts.Take());
+                profiler.EndFrame(sim.Asteroids().Size(), sim.Projectiles().Size());
+                Govern(opts, static_cast<float>(simMs + renderWorkMs));
             }
+        }
+        TraceLog(LOG_INFO, "Governor: %u level changes, ended at %s; %llu simulation ticks dropped",
+            governor.Changes(), FrameGovernor::LevelName(governor.GetLevel()),
+            (unsigned long long)droppedTicks.load());
 
-            // Spawn asteroids
-            if (spawnTimer >= spawnInterval && asteroids.size() < MAX_AST) {
-                asteroids.push_back(MakeAsteroid(C_WIDTH, C_HEIGHT, currentShape));
-                spawnTimer = 0.f;
-                spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
+        WriteProfile(opts);
+        WriteRecording(opts, recording);
+
+        AssetCache::Instance().Unload();
+    }
+
+    // Runs the simulation without a window at a fixed dt with scripted input,
+    // as fast as possible, and reports throughput.
+    int RunHeadless(const LaunchOptions& opts) {
+        // A replay brings its own seed, dt and length; --headless > 0 caps the length
+        InputRecording replay;
+        const bool replaying = opts.replayPath != nullptr;
+        if (replaying && !replay.Load(opts.replayPath)) {
+            fprintf(stderr, "Failed to load replay %s (missing, corrupt or an older format)\n", opts.replayPath);
+            return 1;
+        }
+        const InputRecording::Settings settings = RecordedSettings(opts);
+        if (replaying) {
+            if (const char* diff = SettingsMismatch(replay.GetSettings(), settings)) {
+                fprintf(stderr, "Replay %s was recorded with a different %s\n", opts.replayPath, diff);
+                return 1;
             }
+        }
+        const long long replayTicks = static_cast<long long>(replay.TickCount());
+        const long long ticks = !replaying ? opts.headlessTicks
+            : opts.headlessTicks > 0 ? std::min(opts.headlessTicks, replayTicks) : replayTicks;
+        const float dt = replaying ? replay.Dt() : opts.dt;
+        const uint64_t seed = replaying ? replay.Seed() : opts.hasSeed ? opts.seed : C_HEADLESS_SEED;
 
-            // Update projectiles - check if in boundries and move them forward
-            {
-                auto projectile_to_remove = std::remove_if(projectiles.begin(), projectiles.end(),
-                    [dt](auto& projectile) {
-                        return projectile.Update(dt);
-                    });
-                projectiles.erase(projectile_to_remove, projectiles.end());
+        SimulationConfig config;
+        config.asteroidBounces = opts.bounces;
+        config.bots = opts.bots;
+        Simulation sim(C_WIDTH, C_HEIGHT, seed, config);
+        if (opts.loadWorldPath && !LoadWorld(sim, opts.loadWorldPath)) {
+            return 1;
+        }
+        if (opts.wavesPath && !sim.LoadWaves(opts.wavesPath)) {
+            fprintf(stderr, "Failed to open wave file %s\n", opts.wavesPath);
+            return 1;
+        }
+        ScriptedInput script;
+        InputRecording recording;
+        recording.Begin(seed, dt, settings, opts.recordPath ? static_cast<size_t>(ticks) : 0);
+
+        // Allocations in the second half show what the steady state costs
+        uint64_t allocStart = MemoryStats::Allocations();
+        uint64_t allocHalf = allocStart;
+        auto t0 = std::chrono::steady_clock::now();
+        for (long long i = 0; i < ticks; ++i) {
+            if (i == ticks / 2) {
+                allocHalf = MemoryStats::Allocations();
+            }
+            InputState in = replaying ? replay.At(static_cast<size_t>(i)) : script.Next(sim.Player().IsAlive());
+            if (opts.recordPath) recording.Append(in);
+            Profiler::Instance().BeginFrame();
+            sim.Step(dt, in);
+            Profiler::Instance().EndFrame(sim.Asteroids().Size(), sim.Projectiles().Size());
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        uint64_t allocEnd = MemoryStats::Allocations();
+
+        double seconds = std::chrono::duration<double>(t1 - t0).count();
+        printf("ticks: %lld\n", ticks);
+        printf("dt: %.6f s\n", dt);
+        printf("seed: %llu\n", (unsigned long long)seed);
+        printf("elapsed: %.3f s\n", seconds);
+        printf("ticks/sec: %.1f\n", seconds > 0.0 ? ticks / seconds : 0.0);
+        printf("worker threads: %u\n", JobSystem::Instance().WorkerCount());
+        printf("state hash: %016llx\n", (unsigned long long)sim.StateHash());
+        printf("asteroids: %zu, projectiles: %zu, points: %d\n",
+            sim.Asteroids().Size(), sim.Projectiles().Size(), sim.Points());
+        const auto& pool = sim.Asteroids().Stats();
+        printf("asteroid pool: capacity %zu, peak %zu, acquired %llu, released %llu, full %llu, stale %llu\n",
+            sim.Asteroids().Capacity(), pool.peak, (unsigned long long)pool.acquired,
+            (unsigned long long)pool.released, (unsigned long long)pool.rejectedFull,
+            (unsigned long long)pool.staleHandles);
+        printf("projectiles dropped (store full): %llu\n", (unsigned long long)sim.Projectiles().Dropped());
+        printf("fragments dropped (queue full): %llu\n", (unsigned long long)sim.Fragments().Dropped());
+        printf("heap allocations: %llu total, %llu in second half\n",
+            (unsigned long long)(allocEnd - allocStart), (unsigned long long)(allocEnd - allocHalf));
+        Profiler::Instance().PrintSummary(stdout);
+        WriteProfile(opts);
+        WriteRecording(opts, recording);
+        if (opts.saveWorldPath) {
+            SaveWorld(sim, opts.saveWorldPath);
+        }
+        return 0;
+    }
+
+    // Runs the named benchmark scenario (or all of them) and prints one JSON
+    // object per scenario on stdout, stable keys so runs can be diffed.
+    int RunBench(const LaunchOptions& opts) {
+        const bool all = strcmp(opts.benchName, "all") == 0;
+        bool found = false;
+        for (const BenchScenario& sc : BENCH_SCENARIOS) {
+            if (all || strcmp(opts.benchName, sc.name) == 0) {
+                found = true;
+                RunScenario(sc, opts);
             }
+        }
+        if (!found) {
+            fprintf(stderr, "Unknown scenario: %s (available:", opts.benchName);
+            for (const BenchScenario& sc : BENCH_SCENARIOS) fprintf(stderr, " %s", sc.name);
+            fprintf(stderr, " all)\n");
+            return 1;
+        }
+        return 0;
+    }
 
-            // Projectile-Asteroid collisions O(n^2)
-            for (auto pit = projectiles.begin(); pit != projectiles.end();) {
-                bool removed = false;
+private:
+    Application() = default;
 
-                for (auto ait = asteroids.begin(); ait != asteroids.end(); ++ait) {
-                    float dist = Vector2Distance(pit->GetPosition(), (*ait)->GetPosition());
-                    if (dist < pit->GetRadius() + (*ait)->GetRadius()) {
-                        (*ait)->TakeDamage(pit->GetDamage());
+    static void RunScenario(const BenchScenario& sc, const LaunchOptions& opts) {
+        const uint64_t seed = opts.hasSeed ? opts.seed : C_HEADLESS_SEED;
+        const float dt = opts.dt;
+        const long long ticks = std::max(1LL, opts.benchTicks);
+        // Memory is per scenario, measured from before its simulation exists.
+        // Without a resettable high-water mark the peak is the larger of the
+        // resident sets sampled after warm-up and after the measured ticks.
+        const bool scopedPeak = MemoryStats::ResetPeakRss();
+        const uint64_t rssStartKb = MemoryStats::CurrentRssKb();
+        Simulation sim(C_WIDTH, C_HEIGHT, seed, sc.Config());
+        Profiler& profiler = Profiler::Instance();
 
-                        pit = projectiles.erase(pit);
-                        removed = true;
+        auto input = [&](long long t) {
+            InputState in;
+            in.fire = true;
+            in.left = (t / C_BENCH_LEG_TICKS) % 2 == 0;
+            in.right = !in.left;
+            in.shapeKey = t == 0 ? 4 : 0; // random shapes
+            in.nextWeapon = sc.cycleWeapons && t > 0 && t % C_BENCH_WEAPON_TICKS == 0;
+            return in;
+        };
 
-                        if ((*ait)->IsDestroyed()) {
-                            ait = asteroids.erase(ait);
-                            points++; // Add point when asteroid is destroyed
-                        }
-                        break;
-                    }
-                }
-                if (!removed) {
-                    ++pit;
-                }
+        // Warm up until the load has built up, then measure. A saved world is
+        // already warm.
+        long long t = 0;
+        if (opts.loadWorldPath) {
+            if (!LoadWorld(sim, opts.loadWorldPath)) return;
+            t = C_BENCH_WARMUP_TICKS;
+        }
+        if (opts.wavesPath && !sim.LoadWaves(opts.wavesPath)) {
+            fprintf(stderr, "Failed to open wave file %s\n", opts.wavesPath);
+            return;
+        }
+        for (; t < C_BENCH_WARMUP_TICKS; ++t) {
+            sim.Step(dt, input(t));
+        }
+        uint64_t peakRssKb = MemoryStats::CurrentRssKb();
+        profiler.Reset();
+        const uint64_t allocStart = MemoryStats::Allocations();
+        const uint64_t bytesStart = MemoryStats::BytesAllocated();
+        double entityTicks = 0.0;
+        size_t maxAsteroids = 0, maxProjectiles = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (long long i = 0; i < ticks; ++i, ++t) {
+            profiler.BeginFrame();
+            sim.Step(dt, input(t));
+            profiler.EndFrame(sim.Asteroids().Size(), sim.Projectiles().Size());
+            entityTicks += static_cast<double>(sim.Asteroids().Size() + sim.Projectiles().Size());
+            maxAsteroids = std::max(maxAsteroids, sim.Asteroids().Size());
+            maxProjectiles = std::max(maxProjectiles, sim.Projectiles().Size());
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        peakRssKb = scopedPeak ? MemoryStats::PeakRssKb() : std::max(peakRssKb, MemoryStats::CurrentRssKb());
+
+        const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        printf("{\"scenario\":\"%s\",\"seed\":%llu,\"dt\":%.6f,\"threads\":%u,\"ticks\":%lld,"
+            "\"avg_entities\":%.1f,\"max_asteroids\":%zu,\"max_projectiles\":%zu,\"projectiles_dropped\":%llu,"
+            "\"ns_per_tick\":%.1f,\"ns_per_entity_tick\":%.3f,"
+            "\"allocations\":%llu,\"bytes_allocated\":%llu,\"rss_start_kb\":%llu,\"peak_rss_kb\":%llu,\"phases_avg_ms\":{",
+            sc.name, (unsigned long long)seed, dt, JobSystem::Instance().WorkerCount(), ticks,
+            entityTicks / ticks, maxAsteroids, maxProjectiles, (unsigned long long)sim.Projectiles().Dropped(),
+            ns / ticks, entityTicks > 0.0 ? ns / entityTicks : 0.0,
+            (unsigned long long)(MemoryStats::Allocations() - allocStart),
+            (unsigned long long)(MemoryStats::BytesAllocated() - bytesStart),
+            (unsigned long long)rssStartKb, (unsigned long long)peakRssKb);
+        for (int p = 0; p < Profiler::PHASE_COUNT; ++p) {
+            printf("%s\"%s\":%.4f", p ? "," : "", Profiler::PhaseName(p), profiler.Stats(p).avgMs);
+        }
+        const uint64_t stateHash = sim.StateHash();
+        printf("},\"state_hash\":\"%016llx\",\"index_mismatches\":%llu}\n", (unsigned long long)stateHash,
+            (unsigned long long)sim.CheckAsteroidIndex(C_BENCH_INDEX_CHECK_SIDE));
+        fflush(stdout);
+        if (opts.saveWorldPath) {
+            SaveWorld(sim, opts.saveWorldPath);
+        }
+    }
+
+    // World file I/O with timings on stderr, so bench stdout stays JSON
+    static bool LoadWorld(Simulation& sim, const char* path) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = sim.LoadWorldFile(path);
+        auto t1 = std::chrono::steady_clock::now();
+        if (!ok) {
+            fprintf(stderr, "Failed to load world %s (missing, corrupt, another version or a different --bots count)\n", path);
+            return false;
+        }
+        fprintf(stderr, "world loaded from %s in %.3f ms (%zu asteroids, %zu projectiles)\n", path,
+            std::chrono::duration<double, std::milli>(t1 - t0).count(), sim.Asteroids().Size(), sim.Projectiles().Size());
+        return true;
+    }
+
+    static void SaveWorld(const Simulation& sim, const char* path) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = sim.SaveWorldFile(path);
+        auto t1 = std::chrono::steady_clock::now();
+        if (!ok) {
+            fprintf(stderr, "Failed to save world to %s\n", path);
+            return;
+        }
+        fprintf(stderr, "world saved to %s in %.3f ms (%zu asteroids, %zu projectiles)\n", path,
+            std::chrono::duration<double, std::milli>(t1 - t0).count(), sim.Asteroids().Size(), sim.Projectiles().Size());
+    }
+
+    // Every image is decoded once; the sprites share the atlas
+    void LoadAssets() {
+        AssetCache& assets = AssetCache::Instance();
+        background = assets.LoadTexture("background.jpg");
+        shipSprite = assets.LoadSprite("spaceship.png");
+        projectileSprites.Register(assets);
+        particleSprite = assets.AddSprite("particle", GenImageColor(C_PARTICLE_SPRITE_SIZE, C_PARTICLE_SPRITE_SIZE, WHITE));
+        assets.BuildAtlas();
+        projectileSprites.Resolve(assets);
+        Renderer::Instance().SetSpriteTexture(assets.Atlas());
+    }
+
+    // Draws one published snapshot plus the effects of the impacts reported
+    // since the last frame, and presents the frame
+    void DrawSnapshot(const RenderSnapshot& snap, const std::vector<ImpactEvent>& newImpacts) {
+        Profiler& profiler = Profiler::Instance();
+        const auto t0 = std::chrono::steady_clock::now();
+        {
+            ScopedPhase renderTimer(Profiler::PHASE_RENDER);
+            Renderer& renderer = Renderer::Instance();
+            renderer.Begin();
+
+            const Texture2D& backgroundTexture = AssetCache::Instance().Get(background);
+            if (backgroundTexture.id != 0) {
+                DrawTexture(backgroundTexture, 0, 0, WHITE);
             }
 
-            // Asteroid-Ship collisions
-            {
-                auto remove_collision =
-                    [&player, dt](auto& asteroid_ptr_like) -> bool {
-                    if (player->IsAlive()) {
-                        float dist = Vector2Distance(player->GetPosition(), asteroid_ptr_like->GetPosition());
-
-                        if (dist < player->GetRadius() + asteroid_ptr_like->GetRadius()) {
-                            player->TakeDamage(asteroid_ptr_like->GetDamage());
-                            return true; // Mark asteroid for removal due to collision
-                        }
-                    }
-                    if (!asteroid_ptr_like->Update(dt)) {
-                        return true;
-                    }
-                    return false; // Keep the asteroid
-                    };
-                auto asteroid_to_remove = std::remove_if(asteroids.begin(), asteroids.end(), remove_collision);
-                asteroids.erase(asteroid_to_remove, asteroids.end());
+            const char* weaponName = nullptr;
+            switch (snap.weapon) {
+            case WeaponType::LASER: weaponName = "LASER"; break;
+            case WeaponType::BULLET: weaponName = "BULLET"; break;
+            case WeaponType::SIDE_BLASTER: weaponName = "SIDE_BLASTER"; break;
+            case WeaponType::HOMING: weaponName = "HOMING"; break;
+            case WeaponType::COUNT: break;
             }
 
-            // Render everything
-            {
-                Renderer::Instance().Begin();
+            DrawText(TextFormat("Weapon: %s", weaponName), 10, 40, 20, BLUE);
+            DrawText(TextFormat("Points: %d", snap.points), 10, 70, 20, GREEN); // Display points
+            DrawText(TextFormat("Collisions: %s", snap.broadphase ? "GRID" : "BRUTE"), 10, 100, 20, GRAY);
+            DrawText(TextFormat("Bounces: %s", snap.bounces ? "ON" : "OFF"), 10, 130, 20, GRAY);
 
-                // Draw background if loaded
-                if (background.id != 0) {
-                    DrawTexture(background, 0, 0, WHITE);
-                }
+            culler.Build(snap, renderer.Width(), renderer.Height());
+            for (uint32_t i : culler.Projectiles()) {
+                QueueProjectile(renderer, projectileSprites, { snap.projX[i], snap.projY[i] }, static_cast<WeaponType>(snap.projType[i]));
+            }
+            for (uint32_t i : governor.DrawHpBars() ? culler.Bars() : noBars) {
+                Vector2 pos = { snap.astX[i], snap.astY[i] };
+                float r = snap.astRadius[i];
+                float barWidth = r * 2;
+                float barY = pos.y - r - RenderCuller::BAR_OFFSET;
+                Rectangle backBar = { pos.x - barWidth / 2, barY, barWidth, 5 };
+                Rectangle hpBar = { pos.x - barWidth / 2, barY, barWidth * snap.astHpRatio[i], 5 };
+                renderer.QueueRect(backBar, RED, Renderer::LAYER_BAR_BACK);
+                renderer.QueueRect(hpBar, BLUE, Renderer::LAYER_BAR_FILL);
+            }
+            QueueAsteroidOutlines(renderer, snap.astX.data(), snap.astY.data(), snap.astRadius.data(),
+                snap.astRotation.data(), snap.astKind.data(), culler.Asteroids().data(), culler.Asteroids().size(),
+                culler.PointRadius());
 
-                const char* weaponName = nullptr;
-                switch (currentWeapon) {
-                case WeaponType::LASER: weaponName = "LASER"; break;
-                case WeaponType::BULLET: weaponName = "BULLET"; break;
-                case WeaponType::SIDE_BLASTER: weaponName = "SIDE_BLASTER"; break;
-                }
+            {
+                auto t0 = std::chrono::steady_clock::now();
+                const Kinematics::Bounds screen = { 0.f, 0.f, static_cast<float>(renderer.Width()), static_cast<float>(renderer.Height()) };
+                particles.Emit(newImpacts.data(), newImpacts.size(), governor.ParticleDensity());
+                particles.Update(GetFrameTime(), screen);
+                particleUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                particles.Queue(renderer, AssetCache::Instance().SourceRect(particleSprite));
+            }
 
-                DrawText(TextFormat("Weapon: %s", weaponName), 10, 40, 20, BLUE);
-                DrawText(TextFormat("Points: %d", points), 10, 70, 20, GREEN); // Display points
+            const Rectangle shipSrc = AssetCache::Instance().SourceRect(shipSprite);
+            for (size_t k = 0; k < snap.botPos.size(); ++k) {
+                if (!snap.botAlive[k]) continue;
+                const float w = shipSrc.width * BotShip::SCALE;
+                const float h = shipSrc.height * BotShip::SCALE;
+                renderer.QueueSprite(shipSrc, { snap.botPos[k].x - w * 0.5f, snap.botPos[k].y - h * 0.5f, w, h },
+                    SKYBLUE, Renderer::LAYER_SHIPS);
+            }
 
-                for (const auto& projPtr : projectiles) {
-                    projPtr.Draw();
-                }
-                for (const auto& astPtr : asteroids) {
-                    astPtr->Draw();
-                }
+            // Dead ship blinks until restarted
+            if (snap.shipAlive || fmodf(GetTime(), 0.4f) <= 0.2f) {
+                const Rectangle& src = shipSrc;
+                const float w = src.width * snap.shipScale;
+                const float h = src.height * snap.shipScale;
+                renderer.QueueSprite(src, { snap.shipPos.x - w * 0.5f, snap.shipPos.y - h * 0.5f, w, h },
+                    WHITE, Renderer::LAYER_SHIPS);
+            }
+            renderer.Flush();
 
-                player->Draw();
+            float barWidth = 200.f;
+            float hpPercent = snap.shipMaxHP > 0 ? (float)snap.shipHP / (float)snap.shipMaxHP : 0.f;
+            Rectangle backBar = { 10, 10, barWidth, 20 };
+            Rectangle hpBar = { 10, 10, barWidth * hpPercent, 20 };
+            DrawRectangleRec(backBar, RED);
+            DrawRectangleRec(hpBar, BLUE);
+            DrawText(TextFormat("%d/%d", snap.shipHP, snap.shipMaxHP), 20, 10, 20, BLACK);
 
-                Renderer::Instance().End();
+            if (profiler.OverlayVisible()) {
+                const RenderCuller::Stats& cs = culler.GetStats();
+                DrawText(TextFormat("asteroids drawn %zu, culled %zu, points %zu, bars skipped %zu",
+                    cs.asteroidsDrawn, cs.asteroidsCulled, cs.asteroidsAsPoints, cs.barsSkipped), 10, 160, 20, YELLOW);
+                DrawText(TextFormat("projectiles drawn %zu, culled %zu, merged %zu",
+                    cs.projectilesDrawn, cs.projectilesCulled, cs.projectilesMerged), 10, 182, 20, YELLOW);
+                DrawText(TextFormat("particles %zu, update %.3f ms, dropped %llu",
+                    particles.Size(), particleUpdateMs, (unsigned long long)particles.Dropped()), 10, 204, 20, YELLOW);
+                DrawText(TextFormat("governor %s, frame %.2f / %.2f ms, %u changes, sim ticks dropped %llu",
+                    FrameGovernor::LevelName(governor.GetLevel()), governor.SmoothedMs(), governor.BudgetMs(),
+                    governor.Changes(), (unsigned long long)droppedTicks.load(std::memory_order_relaxed)), 10, 226, 20, YELLOW);
+                profiler.DrawOverlay(10, 254);
             }
         }
+        // Render cost excludes the vsync/frame-limiter wait inside End()
+        renderWorkMs = MillisSince(t0);
+        Renderer::Instance().End();
+    }
+
+    // Keyboard plus the governor's asteroid cap, which reaches the simulation as input
+    InputState PollInput() const {
+        InputState in = PollKeyboard();
+        in.spawnLevel = governor.SpawnLevel();
+        return in;
+    }
 
-        // Unload background texture if it was loaded
-        if (background.id != 0) {
-            UnloadTexture(background);
+    void Govern(const LaunchOptions& opts, float frameMs) {
+        if (opts.governor) {
+            governor.Observe(frameMs);
         }
     }
 
-private:
-    Application()
-    {
-        asteroids.reserve(1000);
-        projectiles.reserve(10'000);
-    };
+    static double Now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static double MillisSince(std::chrono::steady_clock::time_point t0) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
 
-    std::vector<std::unique_ptr<Asteroid>> asteroids;
-    std::vector<Projectile> projectiles;
+    static InputRecording::Settings RecordedSettings(const LaunchOptions& opts) {
+        InputRecording::Settings settings;
+        settings.bots = static_cast<uint32_t>(std::max(opts.bots, 0));
+        settings.bounces = opts.bounces;
+        settings.wavesHash = InputRecording::HashFile(opts.wavesPath);
+        settings.worldHash = InputRecording::HashFile(opts.loadWorldPath);
+        return settings;
+    }
 
-    AsteroidShape currentShape = AsteroidShape::TRIANGLE;
+    // What differs between a recording's settings and this launch, nullptr if nothing
+    static const char* SettingsMismatch(const InputRecording::Settings& recorded, const InputRecording::Settings& current) {
+        if (recorded.bots != current.bots) return "--bots count";
+        if (recorded.bounces != current.bounces) return "--bounces setting";
+        if (recorded.wavesHash != current.wavesHash) return "--waves file";
+        if (recorded.worldHash != current.worldHash) return "--load-world file";
+        return nullptr;
+    }
+
+    static void ReportReplay(const Simulation& sim) {
+        printf("replay finished at tick %llu\n", (unsigned long long)sim.Tick());
+        printf("state hash: %016llx\n", (unsigned long long)sim.StateHash());
+        Profiler::Instance().PrintSummary(stdout);
+        fflush(stdout);
+    }
+
+    static void WriteRecording(const LaunchOptions& opts, const InputRecording& recording) {
+        if (!opts.recordPath) return;
+        if (recording.Save(opts.recordPath)) {
+            TraceLog(LOG_INFO, "Recorded %zu ticks to %s", recording.TickCount(), opts.recordPath);
+        }
+        else {
+            TraceLog(LOG_WARNING, "Failed to write recording to %s", opts.recordPath);
+        }
+    }
+
+    static void WriteProfile(const LaunchOptions& opts) {
+        if (opts.profileCsvPath && !Profiler::Instance().WriteCsv(opts.profileCsvPath)) {
+            TraceLog(LOG_WARNING, "Failed to write profile CSV to %s", opts.profileCsvPath);
+        }
+        if (opts.tracePath && !Profiler::Instance().WriteChromeTrace(opts.tracePath)) {
+            TraceLog(LOG_WARNING, "Failed to write trace to %s", opts.tracePath);
+        }
+    }
 
     static constexpr int C_WIDTH = 1600;
     static constexpr int C_HEIGHT = 1600;
-    static constexpr size_t MAX_AST = 150;
-    static constexpr float C_SPAWN_MIN = 0.5f;
-    static constexpr float C_SPAWN_MAX = 3.0f;
+    RenderCuller      culler;
+    TextureHandle     background;
+    SpriteHandle      shipSprite;
+    ProjectileSprites projectileSprites{};
+    SpriteHandle      particleSprite;
+    ParticleSystem    particles;
+    double            particleUpdateMs = 0.0;
+    RenderSnapshot    frame; // the acquired snapshot, interpolated to this frame's time
+    FrameGovernor     governor;
+    double            renderWorkMs = 0.0;
+    std::atomic<uint64_t> droppedTicks{ 0 }; // simulation ticks skipped to keep up
+    const std::vector<uint32_t> noBars;
 
-    static constexpr int C_MAX_ASTEROIDS = 1000;
-    static constexpr int C_MAX_PROJECTILES = 10'000;
+    static constexpr uint64_t C_HEADLESS_SEED = 1;
+    static constexpr long long C_BENCH_WARMUP_TICKS = 600;
+    static constexpr int C_BENCH_INDEX_CHECK_SIDE = 16; // query grid for the BVH spot check
+    static constexpr int C_BENCH_LEG_TICKS = 45;
+    static constexpr int C_BENCH_WEAPON_TICKS = 120;
+    static constexpr float C_SIM_DT = 1.f / 60.f; // windowed simulation tick
+    static constexpr int C_MAX_CATCHUP_TICKS = 4; // per wake-up or frame, the rest is dropped
+    static constexpr int C_BUDGET_FPS = 60;       // governor budget when the frame rate is uncapped
+    static constexpr size_t C_MAX_PARTICLES = 131'072;
+    static constexpr size_t C_MAX_IMPACT_BACKLOG = 16'384; // impacts waiting for the render thread
+    static constexpr int C_PARTICLE_SPRITE_SIZE = 4;
 };
 
-int main() {
-    Application::Instance().Run();
+// Usage:
+//   asteroids [options]
+//     --headless <ticks>     fixed-step benchmark, no window
+//     --dt <seconds>         headless tick length (default 1/60)
+//     --profile-csv <file>   dump the retained per-phase frame timings as CSV on exit
+//     --trace <file>         dump them as Chrome trace JSON on exit
+//     --threads <n>          job system worker threads (default: cores - 1, 0 = single-threaded)
+//     --no-pipeline          windowed: step the simulation on the render thread
+//     --fps <n>              windowed frame cap and governor budget (default 60, 0 = uncapped)
+//     --no-governor          never shed HP bars, particles or asteroids to hold the frame budget
+//     --seed <n>             simulation seed (default: time windowed, 1 headless)
+//     --record <file>        save the per-tick input and seed on exit
+//     --bounces              asteroids bounce off each other (C toggles it in game)
+//     --bots <n>             add n autopilot ships that dodge and fire (pass the same n to --replay)
+//     --waves <file>         spawn from a timed wave file instead of the random timer
+//                            (bursts are capped only by the asteroid pool; --bench scenarios use it too)
+//     --load-world <file>    start from a saved world instead of an empty field
+//     --save-world <file>    save the world on exit (headless, bench: after the measured ticks)
+//     --bench <name|all>     run stress scenarios headless, one JSON line each
+//                            (asteroid_swarm, bullet_storm, side_blaster_sat, mixed, asteroid_bounces,
+//                            bot_swarm, homing_swarm)
+//     --bench-ticks <n>      measured ticks per scenario after a 600-tick warm-up (default 1000)
+//                            (rss_start_kb is the resident set a scenario starts from, peak_rss_kb
+//                            its high-water mark during that scenario alone; index_mismatches counts
+//                            BVH k-nearest and radius queries that disagree with a brute-force scan)
+//     --replay <file>        drive the simulation from a recording (seed and dt come from the file;
+//                            --headless 0 replays it all), then print the state hash and timings.
+//                            --bots, --bounces, --waves and --load-world must match the recording.
+// F3 toggles the profiler overlay in the windowed game.
+int main(int argc, char** argv) {
+    LaunchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            opts.headlessTicks = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--dt") == 0 && i + 1 < argc) {
+            opts.dt = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+            opts.profileCsvPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            opts.tracePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opts.threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            opts.seed = strtoull(argv[++i], nullptr, 10);
+            opts.hasSeed = true;
+        }
+        else if (strcmp(argv[i], "--waves") == 0 && i + 1 < argc) {
+            opts.wavesPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--load-world") == 0 && i + 1 < argc) {
+            opts.loadWorldPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--save-world") == 0 && i + 1 < argc) {
+            opts.saveWorldPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            opts.benchName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bench-ticks") == 0 && i + 1 < argc) {
+            opts.benchTicks = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            opts.recordPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            opts.replayPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--bots") == 0 && i + 1 < argc) {
+            opts.bots = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            opts.fps = std::max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--no-governor") == 0) {
+            opts.governor = false;
+        }
+        else if (strcmp(argv[i], "--bounces") == 0) {
+            opts.bounces = true;
+        }
+        else if (strcmp(argv[i], "--no-pipeline") == 0) {
+            opts.pipelined = false;
+        }
+        else {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    unsigned workers = opts.threads >= 0
+        ? static_cast<unsigned>(opts.threads)
+        : std::max(1u, std::thread::hardware_concurrency()) - 1;
+    JobSystem::Instance().Start(workers);
+
+    if (opts.benchName) {
+        return Application::Instance().RunBench(opts);
+    }
+    if (opts.headlessTicks >= 0) {
+        return Application::Instance().RunHeadless(opts);
+    }
+    Application::Instance().Run(opts);
     return 0;
 }
\ No newline at end of file